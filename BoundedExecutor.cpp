@@ -0,0 +1,59 @@
+#include "BoundedExecutor.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+
+BoundedExecutor::BoundedExecutor(size_t threadCount, size_t queueCapacity)
+    : m_queueCapacity(std::max<size_t>(queueCapacity, 1)) {
+    threadCount = std::max<size_t>(threadCount, 1);
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&BoundedExecutor::workerLoop, this, i);
+    }
+}
+
+BoundedExecutor::~BoundedExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_notEmpty.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void BoundedExecutor::submit(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_queue.size() < m_queueCapacity; });
+        m_queue.push_back(std::move(task));
+    }
+    m_notEmpty.notify_one();
+}
+
+size_t BoundedExecutor::getThreadCount() const { return m_threads.size(); }
+
+BoundedExecutor& BoundedExecutor::shared() {
+    static BoundedExecutor executor(std::thread::hardware_concurrency(),
+                                    4 * std::max(std::thread::hardware_concurrency(), 1u));
+    return executor;
+}
+
+void BoundedExecutor::workerLoop(size_t index) {
+    TraceRecorder::setThreadName("worker " + std::to_string(index));
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            // Drain the queue before stopping so that no submitted task is dropped
+            if (m_queue.empty()) {
+                return;
+            }
+            task = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_notFull.notify_one();
+        task();
+    }
+}
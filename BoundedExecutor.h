@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class BoundedExecutor
+ * @brief A fixed-size thread pool with a bounded task queue.
+ *
+ * Tasks are run in submission order by a fixed number of worker threads. When the queue is
+ * full, submit() blocks until a worker takes a task, so producers cannot run arbitrarily far
+ * ahead of the workers.
+ */
+class BoundedExecutor {
+public:
+    /**
+     * @brief Starts the worker threads.
+     * @param threadCount The number of worker threads, at least one is always started.
+     * @param queueCapacity The maximum number of tasks waiting to be run, at least one.
+     */
+    BoundedExecutor(size_t threadCount, size_t queueCapacity);
+
+    /**
+     * @brief Runs all queued tasks to completion, then joins the worker threads.
+     */
+    ~BoundedExecutor();
+
+    BoundedExecutor(const BoundedExecutor&) = delete;
+    BoundedExecutor& operator=(const BoundedExecutor&) = delete;
+
+    /**
+     * @brief Queues a task, blocking while the queue is full.
+     *
+     * Tasks must not throw. A task must not submit to the executor it runs on, since it
+     * could block forever on a full queue.
+     *
+     * @param task The task to run on a worker thread.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Retrieves the number of worker threads.
+     * @return The number of worker threads.
+     */
+    size_t getThreadCount() const;
+
+    /**
+     * @brief Retrieves the process-wide executor used for asynchronous analysis.
+     *
+     * It is created on first use with one worker per hardware thread.
+     *
+     * @return A reference to the shared executor.
+     */
+    static BoundedExecutor& shared();
+
+private:
+    size_t m_queueCapacity;
+    bool m_stopping = false;
+    std::deque<std::function<void()>> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::vector<std::thread> m_threads;
+
+    void workerLoop(size_t index);
+};
@@ -0,0 +1,388 @@
+#include "CompressedFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HEADER_ANALYZER_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+const size_t kQueueCapacity = 16;
+const size_t kBlockSize = 1 << 16;
+
+// One streaming codec per file. process() consumes all of input and appends whatever output
+// is ready; with finish set it also flushes the end of the stream.
+class StreamCodec {
+public:
+    virtual ~StreamCodec() = default;
+    virtual bool process(const char* input, size_t size, bool finish, std::string& output) = 0;
+};
+
+class GzipCompressor : public StreamCodec {
+public:
+    GzipCompressor() {
+        std::memset(&m_stream, 0, sizeof(m_stream));
+        // 15 + 16 selects a gzip header and trailer instead of a raw zlib stream
+        m_ok = deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+    ~GzipCompressor() override { if (m_ok) deflateEnd(&m_stream); }
+
+    bool process(const char* input, size_t size, bool finish, std::string& output) override {
+        if (!m_ok) return false;
+        m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+        m_stream.avail_in = static_cast<uInt>(size);
+        int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+        int result;
+        do {
+            char buffer[kBlockSize];
+            m_stream.next_out = reinterpret_cast<Bytef*>(buffer);
+            m_stream.avail_out = sizeof(buffer);
+            result = deflate(&m_stream, flush);
+            if (result == Z_STREAM_ERROR) return false;
+            output.append(buffer, sizeof(buffer) - m_stream.avail_out);
+        } while (m_stream.avail_out == 0 || (finish && result != Z_STREAM_END));
+        return true;
+    }
+
+private:
+    z_stream m_stream;
+    bool m_ok;
+};
+
+class GzipDecompressor : public StreamCodec {
+public:
+    GzipDecompressor() {
+        std::memset(&m_stream, 0, sizeof(m_stream));
+        // 15 + 32 detects the gzip header automatically
+        m_ok = inflateInit2(&m_stream, 15 + 32) == Z_OK;
+    }
+    ~GzipDecompressor() override { if (m_ok) inflateEnd(&m_stream); }
+
+    bool process(const char* input, size_t size, bool finish, std::string& output) override {
+        if (!m_ok) return false;
+        m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+        m_stream.avail_in = static_cast<uInt>(size);
+        while (m_stream.avail_in > 0) {
+            char buffer[kBlockSize];
+            m_stream.next_out = reinterpret_cast<Bytef*>(buffer);
+            m_stream.avail_out = sizeof(buffer);
+            int result = inflate(&m_stream, Z_NO_FLUSH);
+            if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) return false;
+            output.append(buffer, sizeof(buffer) - m_stream.avail_out);
+            m_ended = result == Z_STREAM_END;
+            // Concatenated gzip members decode as one file, like gunzip does
+            if (m_ended && m_stream.avail_in > 0) {
+                inflateReset(&m_stream);
+            } else if (result == Z_BUF_ERROR && m_stream.avail_out != 0) {
+                break;
+            }
+        }
+        return !finish || m_ended;
+    }
+
+private:
+    z_stream m_stream;
+    bool m_ok;
+    bool m_ended = false;
+};
+
+#ifdef HEADER_ANALYZER_WITH_ZSTD
+class ZstdCompressor : public StreamCodec {
+public:
+    ZstdCompressor() : m_context(ZSTD_createCCtx()) {}
+    ~ZstdCompressor() override { ZSTD_freeCCtx(m_context); }
+
+    bool process(const char* input, size_t size, bool finish, std::string& output) override {
+        if (!m_context) return false;
+        ZSTD_inBuffer in = {input, size, 0};
+        ZSTD_EndDirective mode = finish ? ZSTD_e_end : ZSTD_e_continue;
+        size_t remaining;
+        do {
+            char buffer[kBlockSize];
+            ZSTD_outBuffer out = {buffer, sizeof(buffer), 0};
+            remaining = ZSTD_compressStream2(m_context, &out, &in, mode);
+            if (ZSTD_isError(remaining)) return false;
+            output.append(buffer, out.pos);
+        } while (finish ? remaining != 0 : in.pos < in.size);
+        return true;
+    }
+
+private:
+    ZSTD_CCtx* m_context;
+};
+
+class ZstdDecompressor : public StreamCodec {
+public:
+    ZstdDecompressor() : m_context(ZSTD_createDCtx()) {}
+    ~ZstdDecompressor() override { ZSTD_freeDCtx(m_context); }
+
+    bool process(const char* input, size_t size, bool finish, std::string& output) override {
+        if (!m_context) return false;
+        ZSTD_inBuffer in = {input, size, 0};
+        while (in.pos < in.size) {
+            char buffer[kBlockSize];
+            ZSTD_outBuffer out = {buffer, sizeof(buffer), 0};
+            m_pending = ZSTD_decompressStream(m_context, &out, &in);
+            if (ZSTD_isError(m_pending)) return false;
+            output.append(buffer, out.pos);
+        }
+        return !finish || m_pending == 0;
+    }
+
+private:
+    ZSTD_DCtx* m_context;
+    size_t m_pending = 0;
+};
+#endif
+
+std::unique_ptr<StreamCodec> createCompressor(Compression compression) {
+    switch (compression) {
+        case Compression::Gzip: return std::unique_ptr<StreamCodec>(new GzipCompressor());
+#ifdef HEADER_ANALYZER_WITH_ZSTD
+        case Compression::Zstd: return std::unique_ptr<StreamCodec>(new ZstdCompressor());
+#endif
+        default: return nullptr;
+    }
+}
+
+bool endsWith(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+CompressedFileWriter::CompressedFileWriter(const std::string& filename, Compression compression)
+    : m_compression(compression == Compression::Auto ? detectCompression(filename) : compression) {
+    if (!isSupported(m_compression)) {
+        setError("Compression format not supported by this build: " + filename);
+        return;
+    }
+    m_fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        setError("Error opening file for writing: " + filename);
+        return;
+    }
+    if (m_compression != Compression::None) {
+        m_thread = std::thread(&CompressedFileWriter::compressLoop, this);
+    }
+}
+
+CompressedFileWriter::~CompressedFileWriter() {
+    close();
+}
+
+bool CompressedFileWriter::isOpen() const { return m_fd >= 0; }
+const std::string& CompressedFileWriter::getError() const { return m_error; }
+
+void CompressedFileWriter::write(std::string chunk) {
+    if (m_fd < 0 || m_closed || chunk.empty()) {
+        return;
+    }
+    if (m_compression == Compression::None) {
+        if (m_error.empty()) {
+            writeAll(chunk.data(), chunk.size());
+        }
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_queue.size() < kQueueCapacity; });
+        m_queue.push_back(std::move(chunk));
+    }
+    m_notEmpty.notify_one();
+}
+
+void CompressedFileWriter::write(std::vector<std::string> chunks) {
+    if (m_fd < 0 || m_closed) {
+        return;
+    }
+    if (m_compression == Compression::None) {
+        if (m_error.empty()) {
+            writeAll(chunks);
+        }
+        return;
+    }
+    for (auto& chunk : chunks) {
+        write(std::move(chunk));
+    }
+}
+
+bool CompressedFileWriter::close() {
+    if (m_closed) {
+        return m_error.empty();
+    }
+    m_closed = true;
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished = true;
+        }
+        m_notEmpty.notify_one();
+        m_thread.join();
+    }
+    if (m_fd >= 0 && ::close(m_fd) != 0) {
+        setError(std::string("Error closing file: ") + std::strerror(errno));
+    }
+    m_fd = -1;
+    return m_error.empty();
+}
+
+Compression CompressedFileWriter::detectCompression(const std::string& filename) {
+    if (endsWith(filename, ".gz")) return Compression::Gzip;
+    if (endsWith(filename, ".zst")) return Compression::Zstd;
+    return Compression::None;
+}
+
+bool CompressedFileWriter::isSupported(Compression compression) {
+#ifdef HEADER_ANALYZER_WITH_ZSTD
+    (void)compression;
+    return true;
+#else
+    return compression != Compression::Zstd;
+#endif
+}
+
+void CompressedFileWriter::compressLoop() {
+    std::unique_ptr<StreamCodec> compressor = createCompressor(m_compression);
+    bool ok = compressor != nullptr;
+    std::string compressed;
+    for (;;) {
+        std::string chunk;
+        bool finish;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [this] { return m_finished || !m_queue.empty(); });
+            finish = m_queue.empty();
+            if (!finish) {
+                chunk = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+        }
+        m_notFull.notify_one();
+
+        // Keep draining after an error so that the producer never blocks on a full queue
+        if (ok) {
+            compressed.clear();
+            ok = compressor->process(chunk.data(), chunk.size(), finish, compressed);
+            if (!ok) {
+                setError("Error compressing output.");
+            } else {
+                ok = writeAll(compressed.data(), compressed.size());
+            }
+        }
+        if (finish) {
+            return;
+        }
+    }
+}
+
+bool CompressedFileWriter::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(m_fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            setError(std::string("Error writing file: ") + std::strerror(errno));
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool CompressedFileWriter::writeAll(const std::vector<std::string>& chunks) {
+    std::vector<iovec> buffers;
+    buffers.reserve(chunks.size());
+    for (const auto& chunk : chunks) {
+        if (!chunk.empty()) {
+            buffers.push_back({const_cast<char*>(chunk.data()), chunk.size()});
+        }
+    }
+
+    size_t first = 0;
+    while (first < buffers.size()) {
+        int count = static_cast<int>(std::min<size_t>(buffers.size() - first, IOV_MAX));
+        ssize_t written = ::writev(m_fd, &buffers[first], count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            setError(std::string("Error writing file: ") + std::strerror(errno));
+            return false;
+        }
+        // Skip the buffers written completely and resume within a partially written one
+        size_t remaining = static_cast<size_t>(written);
+        while (first < buffers.size() && remaining >= buffers[first].iov_len) {
+            remaining -= buffers[first].iov_len;
+            ++first;
+        }
+        if (remaining > 0) {
+            buffers[first].iov_base = static_cast<char*>(buffers[first].iov_base) + remaining;
+            buffers[first].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+void CompressedFileWriter::setError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_error.empty()) {
+        m_error = error;
+    }
+}
+
+std::string CompressedFileReader::readAll(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Error opening file for reading: " + filename);
+    }
+
+    std::string contents;
+    std::unique_ptr<StreamCodec> decompressor;
+    bool detected = false;
+    std::string block(kBlockSize, '\0');
+    for (;;) {
+        ssize_t count = ::read(fd, &block[0], block.size());
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            throw std::runtime_error("Error reading file: " + filename);
+        }
+
+        // The format is detected from the magic bytes at the start of the first block
+        if (!detected) {
+            detected = true;
+            const unsigned char* magic = reinterpret_cast<const unsigned char*>(block.data());
+            if (count >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+                decompressor.reset(new GzipDecompressor());
+            } else if (count >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+#ifdef HEADER_ANALYZER_WITH_ZSTD
+                decompressor.reset(new ZstdDecompressor());
+#else
+                ::close(fd);
+                throw std::runtime_error("Compression format not supported by this build: " + filename);
+#endif
+            }
+        }
+
+        bool finish = count == 0;
+        if (!decompressor) {
+            contents.append(block.data(), static_cast<size_t>(count));
+        } else if (!decompressor->process(block.data(), static_cast<size_t>(count), finish, contents)) {
+            ::close(fd);
+            throw std::runtime_error("Error decompressing file: " + filename);
+        }
+        if (finish) {
+            break;
+        }
+    }
+
+    ::close(fd);
+    return contents;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @enum Compression
+ * @brief The compression applied to an output file.
+ */
+enum class Compression {
+    Auto, /**< Chosen from the file extension: ".gz" for gzip, ".zst" for zstd, otherwise none. */
+    None, /**< Plain, uncompressed output. */
+    Gzip, /**< gzip via zlib. */
+    Zstd  /**< zstd, only available when built with HEADER_ANALYZER_WITH_ZSTD. */
+};
+
+/**
+ * @class CompressedFileWriter
+ * @brief Writes a file in chunks, compressing them on a separate pipeline thread.
+ *
+ * write() only queues a chunk; a dedicated thread compresses queued chunks and writes them to
+ * disk while the caller keeps formatting the next ones. The queue is bounded, so the caller
+ * blocks if it gets too far ahead. Uncompressed output is written directly by the caller.
+ */
+class CompressedFileWriter {
+public:
+    /**
+     * @brief Opens the output file and starts the compression stage if needed.
+     * @param filename The path of the file to create or truncate.
+     * @param compression The compression to apply, Auto selects it from the extension.
+     */
+    CompressedFileWriter(const std::string& filename, Compression compression = Compression::Auto);
+
+    /**
+     * @brief Closes the file if close() was not called.
+     */
+    ~CompressedFileWriter();
+
+    CompressedFileWriter(const CompressedFileWriter&) = delete;
+    CompressedFileWriter& operator=(const CompressedFileWriter&) = delete;
+
+    /**
+     * @brief Checks whether the file was opened successfully.
+     * @return True if the file is open and chunks can be written.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Queues a chunk of output, in order after all previously written chunks.
+     * @param chunk The bytes to write.
+     */
+    void write(std::string chunk);
+
+    /**
+     * @brief Queues several chunks of output, in order after all previously written chunks.
+     *
+     * Uncompressed output is written with a single writev() call where possible, so callers
+     * that produce many small chunks avoid one system call per chunk.
+     *
+     * @param chunks The chunks to write, in order.
+     */
+    void write(std::vector<std::string> chunks);
+
+    /**
+     * @brief Flushes the compression stage and closes the file.
+     * @return True if every chunk was compressed and written successfully.
+     */
+    bool close();
+
+    /**
+     * @brief Retrieves a description of the first error, if any.
+     * @return The error message, empty if no error occurred.
+     */
+    const std::string& getError() const;
+
+    /**
+     * @brief Resolves Compression::Auto from a file extension.
+     * @param filename The output file name.
+     * @return Gzip for ".gz", Zstd for ".zst", otherwise None.
+     */
+    static Compression detectCompression(const std::string& filename);
+
+    /**
+     * @brief Checks whether a compression format is available in this build.
+     * @param compression The compression format to check.
+     * @return True if files can be written and read with that compression.
+     */
+    static bool isSupported(Compression compression);
+
+private:
+    int m_fd = -1;
+    Compression m_compression;
+    bool m_closed = false;
+    std::string m_error;
+
+    std::thread m_thread;
+    std::deque<std::string> m_queue;
+    bool m_finished = false;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+
+    void compressLoop();
+    bool writeAll(const char* data, size_t size);
+    bool writeAll(const std::vector<std::string>& chunks);
+    void setError(const std::string& error);
+};
+
+/**
+ * @class CompressedFileReader
+ * @brief Reads files written by CompressedFileWriter.
+ */
+class CompressedFileReader {
+public:
+    /**
+     * @brief Reads a whole file, decompressing it on the fly if it is gzip or zstd compressed.
+     *
+     * The format is detected from the file's magic bytes, not its name. The file is read in
+     * blocks and each block is decompressed as it arrives.
+     *
+     * @param filename The path of the file to read.
+     * @return The decompressed contents of the file.
+     * @throws std::runtime_error If the file cannot be read or is not valid compressed data.
+     */
+    static std::string readAll(const std::string& filename);
+};
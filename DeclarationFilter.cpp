@@ -0,0 +1,66 @@
+#include "DeclarationFilter.h"
+#include <algorithm>
+
+void PrefixMatcher::add(const std::string& prefix) {
+    auto position = std::upper_bound(m_prefixes.begin(), m_prefixes.end(), prefix);
+
+    // Already covered by a shorter prefix
+    if (position != m_prefixes.begin() && matches(prefix)) {
+        return;
+    }
+
+    // Drop the longer prefixes the new one covers; they sort directly after it
+    auto end = position;
+    while (end != m_prefixes.end() && end->compare(0, prefix.size(), prefix) == 0) {
+        ++end;
+    }
+    position = m_prefixes.erase(position, end);
+    m_prefixes.insert(position, prefix);
+}
+
+bool PrefixMatcher::matches(const std::string& name) const {
+    auto position = std::upper_bound(m_prefixes.begin(), m_prefixes.end(), name);
+    if (position == m_prefixes.begin()) {
+        return false;
+    }
+    --position;
+    return name.compare(0, position->size(), *position) == 0;
+}
+
+void DeclarationFilter::addIncludePrefix(const std::string& prefix) {
+    m_includePrefixes.add(prefix);
+}
+
+void DeclarationFilter::addExcludePrefix(const std::string& prefix) {
+    m_excludePrefixes.add(prefix);
+}
+
+void DeclarationFilter::addIncludePattern(const std::string& pattern) {
+    m_includePatterns.emplace_back(pattern, std::regex::ECMAScript | std::regex::optimize);
+}
+
+void DeclarationFilter::addExcludePattern(const std::string& pattern) {
+    m_excludePatterns.emplace_back(pattern, std::regex::ECMAScript | std::regex::optimize);
+}
+
+bool DeclarationFilter::acceptsAll() const {
+    return m_kinds == AllKinds && m_includePrefixes.empty() && m_excludePrefixes.empty() &&
+           m_includePatterns.empty() && m_excludePatterns.empty();
+}
+
+bool DeclarationFilter::acceptsName(const std::string& name) const {
+    // Prefixes are checked first since they are much cheaper than the patterns
+    if (!m_includePrefixes.empty() || !m_includePatterns.empty()) {
+        bool included = m_includePrefixes.matches(name) ||
+                        std::any_of(m_includePatterns.begin(), m_includePatterns.end(),
+                                    [&name](const std::regex& pattern) { return std::regex_search(name, pattern); });
+        if (!included) {
+            return false;
+        }
+    }
+    if (m_excludePrefixes.matches(name)) {
+        return false;
+    }
+    return std::none_of(m_excludePatterns.begin(), m_excludePatterns.end(),
+                        [&name](const std::regex& pattern) { return std::regex_search(name, pattern); });
+}
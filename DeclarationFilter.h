@@ -0,0 +1,122 @@
+#pragma once
+
+#include <regex>
+#include <string>
+#include <vector>
+
+/**
+ * @class PrefixMatcher
+ * @brief Matches names against a fixed set of prefixes with one binary search.
+ *
+ * The prefixes are sorted once and every prefix that starts with another prefix of the set is
+ * dropped. In the remaining set no prefix starts with another, so the only prefix that can
+ * match a name is the greatest one that sorts before or equal to it.
+ */
+class PrefixMatcher {
+public:
+    /**
+     * @brief Adds a prefix. An empty prefix matches every name.
+     * @param prefix The prefix to match.
+     */
+    void add(const std::string& prefix);
+
+    /**
+     * @brief Checks whether any prefix was added.
+     * @return True if no prefix was added.
+     */
+    bool empty() const { return m_prefixes.empty(); }
+
+    /**
+     * @brief Checks whether a name starts with one of the prefixes.
+     * @param name The name to check.
+     * @return True if one of the prefixes matches.
+     */
+    bool matches(const std::string& name) const;
+
+private:
+    std::vector<std::string> m_prefixes; // Sorted, no element is a prefix of another
+};
+
+/**
+ * @class DeclarationFilter
+ * @brief Selects which declarations are extracted, by kind and by name.
+ *
+ * A declaration is extracted if its kind is selected, its name matches one of the include
+ * prefixes or patterns (or none were given), and its name matches none of the exclude prefixes
+ * or patterns. HeaderAnalyzer applies the filter during traversal, before a declaration is
+ * processed, so rejected declarations cost little more than reading their name.
+ */
+class DeclarationFilter {
+public:
+    /**
+     * @enum Kind
+     * @brief Declaration kinds, combined as a bitmask.
+     */
+    enum Kind : unsigned {
+        Enums = 1u << 0,
+        Structs = 1u << 1,
+        Functions = 1u << 2,
+        Variables = 1u << 3,
+        Typedefs = 1u << 4,
+        AllKinds = Enums | Structs | Functions | Variables | Typedefs
+    };
+
+    /**
+     * @brief Selects the declaration kinds to extract.
+     * @param kinds A combination of Kind values, AllKinds by default.
+     */
+    void setKinds(unsigned kinds) { m_kinds = kinds; }
+
+    /**
+     * @brief Only extracts declarations whose name starts with this prefix (or another include).
+     * @param prefix The prefix to include, e.g. "mylib_".
+     */
+    void addIncludePrefix(const std::string& prefix);
+
+    /**
+     * @brief Skips declarations whose name starts with this prefix.
+     * @param prefix The prefix to exclude, e.g. "_".
+     */
+    void addExcludePrefix(const std::string& prefix);
+
+    /**
+     * @brief Only extracts declarations whose name matches this ECMAScript regex (or another include).
+     * @param pattern The pattern, searched anywhere in the name unless anchored (e.g. "^mylib_").
+     * @throws std::regex_error If the pattern is invalid.
+     */
+    void addIncludePattern(const std::string& pattern);
+
+    /**
+     * @brief Skips declarations whose name matches this ECMAScript regex.
+     * @param pattern The pattern, searched anywhere in the name unless anchored.
+     * @throws std::regex_error If the pattern is invalid.
+     */
+    void addExcludePattern(const std::string& pattern);
+
+    /**
+     * @brief Checks whether the filter accepts every declaration.
+     * @return True if all kinds are selected and no name filter was added.
+     */
+    bool acceptsAll() const;
+
+    /**
+     * @brief Checks whether declarations of a kind are extracted at all.
+     * @param kind The declaration kind.
+     * @return True if the kind is selected.
+     */
+    bool acceptsKind(Kind kind) const { return (m_kinds & kind) != 0; }
+
+    /**
+     * @brief Checks whether a declaration name passes the include and exclude filters.
+     * @param name The name of the declaration.
+     * @return True if the declaration should be extracted.
+     */
+    bool acceptsName(const std::string& name) const;
+
+private:
+    unsigned m_kinds = AllKinds;
+    PrefixMatcher m_includePrefixes;
+    PrefixMatcher m_excludePrefixes;
+    std::vector<std::regex> m_includePatterns;
+    std::vector<std::regex> m_excludePatterns;
+};
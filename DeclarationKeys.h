@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Keys declarations by name, for pairing up the declarations of two analyses.
+ *
+ * Repeated names (e.g., redeclared typedefs or anonymous members) get an occurrence suffix, so
+ * the n-th occurrence of a name in one analysis is paired with the n-th in the other.
+ *
+ * @param declarations The declarations to key, in declaration order.
+ * @param getName Returns a declaration's name as a const std::string reference.
+ * @return One key per declaration, in the same order.
+ */
+template <typename Info, typename NameFn>
+std::vector<std::string> makeDeclarationKeys(const std::vector<Info>& declarations, NameFn getName) {
+    std::vector<std::string> keys;
+    keys.reserve(declarations.size());
+    std::unordered_map<std::string, size_t> occurrences;
+    occurrences.reserve(declarations.size());
+    for (const auto& info : declarations) {
+        const std::string& name = getName(info);
+        size_t count = occurrences[name]++;
+        keys.push_back(count == 0 ? name : name + "#" + std::to_string(count));
+    }
+    return keys;
+}
@@ -0,0 +1,285 @@
+#include "EnumTableGenerator.h"
+#include "CompressedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+// Upper bound on the seeds tried for one bucket. With as many buckets as keys, a free
+// placement is found after a handful of attempts, so this only guards against a broken hash.
+const uint32_t kMaxSeed = 1u << 24;
+
+// Helpers shared by all generated tables; enumNameHash must match EnumTableGenerator::hash
+const char* kGeneratedPrologue =
+    "#include <cstddef>\n"
+    "#include <cstdint>\n"
+    "#include <iterator>\n"
+    "#include <string_view>\n"
+    "\n"
+    "#ifndef HEADER_ANALYZER_ENUM_TABLES_DETAIL\n"
+    "#define HEADER_ANALYZER_ENUM_TABLES_DETAIL\n"
+    "namespace header_analyzer_detail {\n"
+    "\n"
+    "struct EnumEntry {\n"
+    "    std::string_view name;\n"
+    "    long long value;\n"
+    "};\n"
+    "\n"
+    "constexpr std::uint32_t enumNameHash(std::uint32_t seed, std::string_view name) noexcept {\n"
+    "    std::uint32_t h = 2166136261u ^ (seed * 16777619u);\n"
+    "    for (char c : name) {\n"
+    "        h ^= static_cast<unsigned char>(c);\n"
+    "        h *= 16777619u;\n"
+    "    }\n"
+    "    h ^= h >> 16;\n"
+    "    h *= 0x85ebca6bu;\n"
+    "    h ^= h >> 13;\n"
+    "    h *= 0xc2b2ae35u;\n"
+    "    h ^= h >> 16;\n"
+    "    return h;\n"
+    "}\n"
+    "\n"
+    "} // namespace header_analyzer_detail\n"
+    "#endif\n";
+
+std::string valueLiteral(long long value) {
+    // The most negative value has no literal of its own
+    if (value == LLONG_MIN) {
+        return "(-9223372036854775807LL - 1)";
+    }
+    return std::to_string(value) + "LL";
+}
+
+} // namespace
+
+EnumTableGenerator::EnumTableGenerator(const HeaderAnalyzer& analyzer, const std::string& namespaceName)
+    : m_namespace(namespaceName) {
+    std::unordered_set<std::string> seen;
+    for (const auto& info : analyzer.getEnums()) {
+        if (isIdentifier(info.name) && seen.insert(info.name).second) {
+            m_enums.push_back(&info);
+        }
+    }
+}
+
+bool EnumTableGenerator::isIdentifier(const std::string& name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    });
+}
+
+uint32_t EnumTableGenerator::hash(uint32_t seed, const std::string& name) {
+    uint32_t h = 2166136261u ^ (seed * 16777619u);
+    for (char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    // Final avalanche so that nearby seeds give unrelated slots
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+EnumTableGenerator::PerfectHash EnumTableGenerator::buildPerfectHash(const std::vector<std::string>& names) {
+    const size_t n = names.size();
+    PerfectHash result;
+    result.seeds.assign(n, 0);
+    result.slots.assign(n, 0);
+
+    // Distribute the keys into buckets with the seed-0 hash
+    std::vector<std::vector<size_t>> buckets(n);
+    for (size_t i = 0; i < n; ++i) {
+        buckets[hash(0, names[i]) % n].push_back(i);
+    }
+
+    // Place the largest buckets first, while most slots are still free
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&buckets](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<bool> used(n, false);
+    std::vector<size_t> candidate;
+    size_t position = 0;
+    for (; position < n && buckets[order[position]].size() > 1; ++position) {
+        const std::vector<size_t>& bucket = buckets[order[position]];
+        uint32_t seed = 1;
+        for (;; ++seed) {
+            if (seed == kMaxSeed) {
+                throw std::runtime_error("Unable to build a perfect hash for enumerator names");
+            }
+            candidate.clear();
+            bool placed = true;
+            for (size_t key : bucket) {
+                size_t slot = hash(seed, names[key]) % n;
+                if (used[slot] || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+                    placed = false;
+                    break;
+                }
+                candidate.push_back(slot);
+            }
+            if (placed) {
+                break;
+            }
+        }
+        result.seeds[order[position]] = static_cast<int32_t>(seed);
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            used[candidate[i]] = true;
+            result.slots[candidate[i]] = bucket[i];
+        }
+    }
+
+    // Buckets with a single key point straight at a free slot
+    size_t freeSlot = 0;
+    for (; position < n && buckets[order[position]].size() == 1; ++position) {
+        while (used[freeSlot]) {
+            ++freeSlot;
+        }
+        used[freeSlot] = true;
+        result.seeds[order[position]] = -static_cast<int32_t>(freeSlot) - 1;
+        result.slots[freeSlot] = buckets[order[position]][0];
+    }
+
+    return result;
+}
+
+void EnumTableGenerator::generateEnum(std::string& out, const HeaderAnalyzer::EnumInfo& info) {
+    // Repeated enumerator names cannot occur in valid code, but would break the perfect hash
+    std::vector<std::pair<std::string, long long>> enumerators;
+    std::unordered_set<std::string> names;
+    for (const auto& enumerator : info.enumerators) {
+        if (names.insert(enumerator.first).second) {
+            enumerators.push_back(enumerator);
+        }
+    }
+    const size_t n = enumerators.size();
+
+    out += "// enum " + info.name;
+    if (!info.underlyingType.empty()) {
+        out += " : " + info.underlyingType;
+    }
+    out += "\nnamespace " + info.name + " {\n\n";
+
+    if (n == 0) {
+        out += "constexpr std::string_view toString(long long) noexcept { return std::string_view(); }\n";
+        out += "constexpr bool fromString(std::string_view, long long&) noexcept { return false; }\n";
+        out += "\n} // namespace " + info.name + "\n\n";
+        return;
+    }
+
+    // Value to name. With aliases, the first enumerator of a value names it.
+    std::vector<size_t> byValue(n);
+    std::iota(byValue.begin(), byValue.end(), 0);
+    std::stable_sort(byValue.begin(), byValue.end(), [&enumerators](size_t a, size_t b) {
+        return enumerators[a].second < enumerators[b].second;
+    });
+    byValue.erase(std::unique(byValue.begin(), byValue.end(), [&enumerators](size_t a, size_t b) {
+        return enumerators[a].second == enumerators[b].second;
+    }), byValue.end());
+
+    long long first = enumerators[byValue.front()].second;
+    unsigned long long span = static_cast<unsigned long long>(enumerators[byValue.back()].second) -
+                              static_cast<unsigned long long>(first);
+    bool dense = span == byValue.size() - 1;
+
+    if (dense) {
+        out += "inline constexpr long long kFirstValue = " + valueLiteral(first) + ";\n";
+        out += "inline constexpr std::string_view kByValue[] = {";
+        for (size_t i = 0; i < byValue.size(); ++i) {
+            out += (i % 4 == 0 ? "\n    " : " ") + ("\"" + enumerators[byValue[i]].first + "\",");
+        }
+        out += "\n};\n\n";
+        out += "constexpr std::string_view toString(long long value) noexcept {\n"
+               "    std::uint64_t index = static_cast<std::uint64_t>(value) - static_cast<std::uint64_t>(kFirstValue);\n"
+               "    return index < std::size(kByValue) ? kByValue[index] : std::string_view();\n"
+               "}\n\n";
+    } else {
+        out += "inline constexpr header_analyzer_detail::EnumEntry kByValue[] = {";
+        for (size_t i : byValue) {
+            out += "\n    {\"" + enumerators[i].first + "\", " + valueLiteral(enumerators[i].second) + "},";
+        }
+        out += "\n};\n\n";
+        out += "constexpr std::string_view toString(long long value) noexcept {\n"
+               "    std::size_t low = 0;\n"
+               "    std::size_t high = std::size(kByValue);\n"
+               "    while (low < high) {\n"
+               "        std::size_t middle = low + (high - low) / 2;\n"
+               "        if (kByValue[middle].value < value) {\n"
+               "            low = middle + 1;\n"
+               "        } else {\n"
+               "            high = middle;\n"
+               "        }\n"
+               "    }\n"
+               "    return low < std::size(kByValue) && kByValue[low].value == value ? kByValue[low].name : std::string_view();\n"
+               "}\n\n";
+    }
+
+    // Name to value through the perfect hash
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (const auto& enumerator : enumerators) {
+        keys.push_back(enumerator.first);
+    }
+    PerfectHash perfectHash = buildPerfectHash(keys);
+
+    out += "inline constexpr std::int32_t kSeeds[] = {";
+    for (size_t i = 0; i < n; ++i) {
+        out += (i % 8 == 0 ? "\n    " : " ") + std::to_string(perfectHash.seeds[i]) + ",";
+    }
+    out += "\n};\n\n";
+    out += "inline constexpr header_analyzer_detail::EnumEntry kByName[] = {";
+    for (size_t slot : perfectHash.slots) {
+        out += "\n    {\"" + enumerators[slot].first + "\", " + valueLiteral(enumerators[slot].second) + "},";
+    }
+    out += "\n};\n\n";
+    out += "constexpr bool fromString(std::string_view name, long long& value) noexcept {\n"
+           "    std::int32_t seed = kSeeds[header_analyzer_detail::enumNameHash(0, name) % std::size(kSeeds)];\n"
+           "    std::size_t slot = seed < 0 ? static_cast<std::size_t>(-seed - 1)\n"
+           "                                : header_analyzer_detail::enumNameHash(static_cast<std::uint32_t>(seed), name) % std::size(kByName);\n"
+           "    if (kByName[slot].name != name) {\n"
+           "        return false;\n"
+           "    }\n"
+           "    value = kByName[slot].value;\n"
+           "    return true;\n"
+           "}\n";
+
+    out += "\n} // namespace " + info.name + "\n\n";
+}
+
+std::string EnumTableGenerator::generate() const {
+    std::string out;
+    out += "// Generated by HeaderAnalyzer. Do not edit.\n";
+    out += "#pragma once\n\n";
+    out += kGeneratedPrologue;
+    out += "\nnamespace " + m_namespace + " {\n\n";
+    for (const auto* info : m_enums) {
+        generateEnum(out, *info);
+    }
+    out += "} // namespace " + m_namespace + "\n";
+    return out;
+}
+
+void EnumTableGenerator::writeToHeader(const std::string& outputFilename) const {
+    CompressedFileWriter outFile(outputFilename, Compression::None);
+    if (!outFile.isOpen()) {
+        std::cerr << outFile.getError() << std::endl;
+        return;
+    }
+
+    outFile.write(generate());
+
+    if (!outFile.close()) {
+        std::cerr << outFile.getError() << std::endl;
+    }
+}
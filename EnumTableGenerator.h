@@ -0,0 +1,72 @@
+#pragma once
+
+#include "HeaderAnalyzer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class EnumTableGenerator
+ * @brief Generates a C++ header with constexpr name/value lookup tables for every enum.
+ *
+ * For each named enum the generated header declares a namespace with two functions:
+ *
+ *   constexpr std::string_view toString(long long value) noexcept;
+ *   constexpr bool fromString(std::string_view name, long long& value) noexcept;
+ *
+ * Value to name uses a dense array indexed by value when the values are contiguous, otherwise a
+ * sorted table searched with a binary search. Name to value uses a minimal perfect hash computed
+ * at generation time (hash and displace), so a lookup hashes the name once and compares it with
+ * a single candidate. Neither direction allocates.
+ */
+class EnumTableGenerator {
+public:
+    /**
+     * @brief Prepares tables for the enums of an analyzed header.
+     *
+     * Enums whose name is not a valid identifier (e.g. anonymous enums) and repeated enum names
+     * are skipped.
+     *
+     * @param analyzer The analyzer holding the enums.
+     * @param namespaceName The namespace the generated tables are placed in.
+     */
+    EnumTableGenerator(const HeaderAnalyzer& analyzer, const std::string& namespaceName);
+
+    /**
+     * @brief Generates the header source.
+     * @return The contents of the generated C++ header.
+     */
+    std::string generate() const;
+
+    /**
+     * @brief Writes the generated header to a file.
+     * @param outputFilename The name of the output header file.
+     */
+    void writeToHeader(const std::string& outputFilename) const;
+
+    /**
+     * @brief Computes the hash used by the generated name lookup.
+     *
+     * This is 32-bit FNV-1a with the seed folded into the offset basis. The generated header
+     * contains the same function as constexpr code.
+     *
+     * @param seed The displacement seed of the bucket.
+     * @param name The name to hash.
+     * @return The 32-bit hash.
+     */
+    static uint32_t hash(uint32_t seed, const std::string& name);
+
+private:
+    // A perfect hash over the enumerator names of one enum
+    struct PerfectHash {
+        std::vector<int32_t> seeds; // Per bucket: a seed >= 0, or -(slot + 1) for a single key
+        std::vector<size_t> slots; // Enumerator index stored in each slot
+    };
+
+    std::string m_namespace;
+    std::vector<const HeaderAnalyzer::EnumInfo*> m_enums;
+
+    static bool isIdentifier(const std::string& name);
+    static PerfectHash buildPerfectHash(const std::vector<std::string>& names);
+    static void generateEnum(std::string& out, const HeaderAnalyzer::EnumInfo& info);
+};
@@ -1,281 +1,152 @@
 #include "HeaderAnalyzer.h"
+#include "BoundedExecutor.h"
+#include "CompressedFile.h"
+#include "HeaderVisitor.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 #include <sstream>
-#include <fstream>
 #include <stdexcept>
-#include <unordered_set>
-
-HeaderAnalyzer::HeaderAnalyzer(const std::string& filename) : m_filename(filename) {
-    m_index = clang_createIndex(0, 0);
-    m_translationUnit = clang_parseTranslationUnit(
-        m_index,
-        m_filename.c_str(), nullptr, 0,
-        nullptr, 0,
-        CXTranslationUnit_None);
-
-    if (m_translationUnit == nullptr) {
-        throw std::runtime_error("Unable to parse translation unit.");
-    }
+#include <thread>
 
-    CXCursor cursor = clang_getTranslationUnitCursor(m_translationUnit);
-    clang_visitChildren(cursor, &HeaderAnalyzer::visitNode, this);
-}
+namespace {
 
-HeaderAnalyzer::~HeaderAnalyzer() {
-    if (m_translationUnit)
-        clang_disposeTranslationUnit(m_translationUnit);
-    if (m_index)
-        clang_disposeIndex(m_index);
-}
+// Size at which buffered output is handed to the (possibly compressing) file writer
+const size_t kOutputChunkSize = 1 << 18;
 
-const std::vector<HeaderAnalyzer::EnumInfo>& HeaderAnalyzer::getEnums() const { return m_enums; }
-const std::vector<HeaderAnalyzer::StructInfo>& HeaderAnalyzer::getStructs() const { return m_structs; }
-const std::vector<HeaderAnalyzer::FunctionInfo>& HeaderAnalyzer::getFunctions() const { return m_functions; }
-const std::vector<HeaderAnalyzer::VariableInfo>& HeaderAnalyzer::getVariables() const { return m_variables; }
-const std::vector<HeaderAnalyzer::TypedefInfo>& HeaderAnalyzer::getTypedefs() const { return m_typedefs; }
-
-CXChildVisitResult HeaderAnalyzer::visitNode(CXCursor cursor, CXCursor parent, CXClientData client_data) {
-	auto* analyzer = static_cast<HeaderAnalyzer*>(client_data);
-	CXCursorKind kind = clang_getCursorKind(cursor);
-
-	// Get the name of the cursor
-	CXString cursorName = clang_getCursorSpelling(cursor);
-	std::string name = clang_getCString(cursorName);
-	clang_disposeString(cursorName); // Clean up the CXString
-
-	// Check if the name has already been processed
-	if (kind != CXCursor_TypedefDecl && analyzer->m_processedNames.find(name) != analyzer->m_processedNames.end()) {
-	    return CXChildVisit_Recurse; // Skip processing if already processed
-	}
-
-	// Process the cursor and mark the name as processed
-	switch (kind) {
-	    case CXCursor_EnumDecl:
-		analyzer->m_enums.push_back(processEnum(cursor));
-		break;
-	    case CXCursor_StructDecl:
-		analyzer->m_structs.push_back(processStruct(cursor));
-		break;
-	    case CXCursor_FunctionDecl:
-		analyzer->m_functions.push_back(processFunction(cursor));
-		break;
-	    case CXCursor_VarDecl:
-		analyzer->m_variables.push_back(processVariable(cursor));
-		break;
-	    case CXCursor_TypedefDecl:
-		analyzer->m_typedefs.push_back(processTypedef(cursor));
-		break;
-	}
-
-	// Mark the name as processed
-	analyzer->m_processedNames.insert(name);
-
-	return CXChildVisit_Recurse;
-}
+// Entries formatted as one unit when writing on several threads
+const size_t kEntriesPerChunk = 256;
 
-std::string HeaderAnalyzer::getCursorSpelling(CXCursor cursor) {
-    CXString spelling = clang_getCursorSpelling(cursor);
-    const char* cStr = clang_getCString(spelling);
-    std::string result = cStr ? cStr : ""; // Ensure we return an empty string if null
-    clang_disposeString(spelling);
-    return result;
-}
+// Formatted chunks allowed to wait for the writer, per formatting thread
+const size_t kChunksInFlightPerThread = 4;
 
-std::string HeaderAnalyzer::getCursorType(CXCursor cursor) {
-    CXType type = clang_getCursorType(cursor);
-    CXString spelling = clang_getTypeSpelling(type);
-    const char* cStr = clang_getCString(spelling);
-    std::string result = cStr ? cStr : ""; // Ensure we return an empty string if null
-    clang_disposeString(spelling);
-    return result;
-}
+// The XML sections, in output order
+enum Section : size_t { EnumSection, TypedefSection, StructSection, VariableSection, FunctionSection, SectionCount };
+const char* const kSectionNames[SectionCount] = {"enums", "typedefs", "structs", "variables", "functions"};
 
-std::string HeaderAnalyzer::getCursorResultType(CXCursor cursor) {
-    CXType type = clang_getCursorResultType(cursor);
-    CXString spelling = clang_getTypeSpelling(type);
-    const char* cStr = clang_getCString(spelling);
-    std::string result = cStr ? cStr : ""; // Ensure we return an empty string if null
-    clang_disposeString(spelling);
-    return result;
+const char* sectionName(DeclarationFilter::Kind kind) {
+    switch (kind) {
+        case DeclarationFilter::Enums: return kSectionNames[EnumSection];
+        case DeclarationFilter::Typedefs: return kSectionNames[TypedefSection];
+        case DeclarationFilter::Structs: return kSectionNames[StructSection];
+        case DeclarationFilter::Variables: return kSectionNames[VariableSection];
+        default: return kSectionNames[FunctionSection];
+    }
 }
 
-std::string HeaderAnalyzer::getComment(CXCursor cursor) {
-    CXString comment = clang_Cursor_getBriefCommentText(cursor);
-    const char* cStr = clang_getCString(comment);
-    std::string result = cStr ? cStr : ""; // Ensure we return an empty string if null
-    clang_disposeString(comment);
-    return result;
-}
+} // namespace
 
-HeaderAnalyzer::EnumInfo HeaderAnalyzer::processEnum(CXCursor cursor) {
-    EnumInfo info;
-    info.name = getCursorSpelling(cursor);
-    info.comment = getComment(cursor);
-
-    clang_visitChildren(
-        cursor,
-        [](CXCursor c, CXCursor parent, CXClientData client_data) {
-            auto* info = static_cast<EnumInfo*>(client_data);
-            if (clang_getCursorKind(c) == CXCursor_EnumConstantDecl) {
-                std::string name = getCursorSpelling(c);
-                long long value = clang_getEnumConstantDeclValue(c);
-                info->enumerators.emplace_back(name, value);
-            }
-            return CXChildVisit_Continue;
-        },
-        &info
-    );
-
-    CXType enumType = clang_getCursorType(cursor);
-    CXType underlyingType = clang_getEnumDeclIntegerType(cursor);
-    CXString underlyingTypeSpelling = clang_getTypeSpelling(underlyingType);
-    info.underlyingType = clang_getCString(underlyingTypeSpelling);
-    clang_disposeString(underlyingTypeSpelling);
-
-    return info;
-}
+// Stores every declaration with every field, which makes the analyzer itself a HeaderVisitor
+struct HeaderAnalyzer::Extractor : HeaderVisitorPolicy {
+    HeaderAnalyzer& analyzer;
 
-HeaderAnalyzer::StructInfo HeaderAnalyzer::processStruct(CXCursor cursor) {
-    StructInfo info;
-    info.name = getCursorSpelling(cursor);
-    info.comment = getComment(cursor);
-
-    clang_visitChildren(
-        cursor,
-        [](CXCursor c, CXCursor parent, CXClientData client_data) {
-            auto* info = static_cast<StructInfo*>(client_data);
-            if (clang_getCursorKind(c) == CXCursor_FieldDecl) {
-                StructMember member;
-                member.name = getCursorSpelling(c);
-                member.type = getCursorType(c);
-                member.bitfieldWidth = clang_getFieldDeclBitWidth(c);
-                info->members.push_back(member);
-            }
-            return CXChildVisit_Continue;
-        },
-        &info
-    );
+    explicit Extractor(HeaderAnalyzer& analyzer) : analyzer(analyzer) {}
 
-    return info;
-}
+    void onEnum(EnumInfo&& info) { analyzer.m_enums.push_back(std::move(info)); }
+    void onStruct(StructInfo&& info) { analyzer.m_structs.push_back(std::move(info)); }
+    void onFunction(FunctionInfo&& info) { analyzer.m_functions.push_back(std::move(info)); }
+    void onVariable(VariableInfo&& info) { analyzer.m_variables.push_back(std::move(info)); }
+    void onTypedef(TypedefInfo&& info) { analyzer.m_typedefs.push_back(std::move(info)); }
+};
 
-HeaderAnalyzer::FunctionInfo HeaderAnalyzer::processFunction(CXCursor cursor) {
-    FunctionInfo info;
-    info.name = getCursorSpelling(cursor);
-    info.returnType = getCursorResultType(cursor);
-    info.comment = getComment(cursor);
-
-    int numArgs = clang_Cursor_getNumArguments(cursor);
-    for (int i = 0; i < numArgs; ++i) {
-        CXCursor arg = clang_Cursor_getArgument(cursor, i);
-        std::string argName = getCursorSpelling(arg);
-        std::string argType = getCursorType(arg);
-        info.parameters.emplace_back(argName, argType);
-    }
+// Formats the declarations visited from an analyzer as the sections of writeToXML
+struct HeaderAnalyzer::XMLFormatter : HeaderVisitorPolicy {
+    std::string& xml;
+    CompressedFileWriter& outFile;
 
-    info.isVariadic = clang_isFunctionTypeVariadic(clang_getCursorType(cursor));
+    XMLFormatter(std::string& xml, CompressedFileWriter& outFile) : xml(xml), outFile(outFile) {}
 
-    CXString attrSpelling = clang_getCursorDisplayName(cursor);
-    const char* cStr = clang_getCString(attrSpelling);
-    info.attributes = cStr ? cStr : ""; // Ensure we return an empty string if null
-    clang_disposeString(attrSpelling);
+    void beginSection(DeclarationFilter::Kind kind) { xml += std::string("  <") + sectionName(kind) + ">\n"; }
+    void endSection(DeclarationFilter::Kind kind) { xml += std::string("  </") + sectionName(kind) + ">\n"; }
 
-    return info;
-}
+    void onEnum(const EnumInfo& info) { append(enumToXML(info)); }
+    void onStruct(const StructInfo& info) { append(structToXML(info)); }
+    void onFunction(const FunctionInfo& info) { append(functionToXML(info)); }
+    void onVariable(const VariableInfo& info) { append(variableToXML(info)); }
+    void onTypedef(const TypedefInfo& info) { append(typedefToXML(info)); }
 
-HeaderAnalyzer::VariableInfo HeaderAnalyzer::processVariable(CXCursor cursor) {
-    VariableInfo info = initializeVariableInfo(cursor);
-    info.storageClass = getStorageClass(cursor);
-    info.qualifiers = getTypeQualifiers(cursor);
-    info.arrayDimensions = getArrayDimensions(cursor);
-    info.value = evaluateVariable(cursor);
-    
-    return info;
-}
+    void append(const std::string& text) {
+        xml += text;
+        if (xml.size() >= kOutputChunkSize) {
+            outFile.write(std::move(xml));
+            xml.clear();
+        }
+    }
+};
 
-HeaderAnalyzer::VariableInfo HeaderAnalyzer::initializeVariableInfo(CXCursor cursor) {
-    VariableInfo info;
-    info.name = getCursorSpelling(cursor);
-    info.type = getCursorType(cursor);
-    info.comment = getComment(cursor);
-    return info;
+HeaderAnalyzer::HeaderAnalyzer(const std::string& filename) : HeaderAnalyzer(filename, Options()) {
 }
 
-std::string HeaderAnalyzer::getStorageClass(CXCursor cursor) {
-    CX_StorageClass storageClass = clang_Cursor_getStorageClass(cursor);
-    switch (storageClass) {
-        case CX_SC_None: return "";
-        case CX_SC_Extern: return "extern";
-        case CX_SC_Static: return "static";
-        case CX_SC_PrivateExtern: return "private extern";
-        case CX_SC_Auto: return "auto";
-        case CX_SC_Register: return "register";
-        default: return "unknown";
-    }
+HeaderAnalyzer::HeaderAnalyzer(const std::string& filename, const Options& options) : m_filename(filename) {
+    analyze(options, nullptr);
 }
 
-std::string HeaderAnalyzer::getTypeQualifiers(CXCursor cursor) {
-    CXType type = clang_getCursorType(cursor);
-    std::string qualifiers;
-
-    if (clang_isConstQualifiedType(type)) qualifiers += "const ";
-    if (clang_isVolatileQualifiedType(type)) qualifiers += "volatile ";
-
-    return qualifiers;
+HeaderAnalyzer::HeaderAnalyzer(const std::string& filename, const std::string& contents)
+    : HeaderAnalyzer(filename, contents, Options()) {
 }
 
-std::vector<int> HeaderAnalyzer::getArrayDimensions(CXCursor cursor) {
-    CXType type = clang_getCursorType(cursor);
-    std::vector<int> dimensions;
-
-    while (clang_getArraySize(type) != -1) {
-        dimensions.push_back(clang_getArraySize(type));
-        type = clang_getArrayElementType(type);
-    }
-
-    return dimensions;
+HeaderAnalyzer::HeaderAnalyzer(const std::string& filename, const std::string& contents, const Options& options)
+    : m_filename(filename) {
+    analyze(options, &contents);
 }
 
-std::string HeaderAnalyzer::evaluateVariable(CXCursor cursor) {
-    CXEvalResult evalResult = clang_Cursor_Evaluate(cursor);
-    CXEvalResultKind kind = clang_EvalResult_getKind(evalResult);
-    std::string value;
-
-    switch (kind) {
-        case CXEval_Int:
-            value = std::to_string(clang_EvalResult_getAsInt(evalResult));
-            break;
-        case CXEval_Float:
-            value = std::to_string(clang_EvalResult_getAsDouble(evalResult));
-            break;
-        case CXEval_ObjCStrLiteral:
-        case CXEval_StrLiteral:
-        case CXEval_CFStr:
-            value = clang_EvalResult_getAsStr(evalResult);
-            break;
-        default:
-            value = "Unable to evaluate";
+void HeaderAnalyzer::analyze(const Options& options, const std::string* contents) {
+    Extractor extractor(*this);
+    HeaderVisitor<Extractor> visitor(extractor);
+    if (contents) {
+        visitor.traverse(m_filename, *contents, options);
+    } else {
+        visitor.traverse(m_filename, options);
     }
-    
-    clang_EvalResult_dispose(evalResult);
-    return value;
+    m_typeSpellingStatistics = visitor.getTypeSpellingStatistics();
+    m_translationUnitMemory = visitor.getTranslationUnitMemory();
+
+    // The visitor disposed of the AST as soon as it finished, so a cached analyzer only holds
+    // its declarations
+    m_enums.shrink_to_fit();
+    m_structs.shrink_to_fit();
+    m_functions.shrink_to_fit();
+    m_variables.shrink_to_fit();
+    m_typedefs.shrink_to_fit();
 }
 
-HeaderAnalyzer::TypedefInfo HeaderAnalyzer::processTypedef(CXCursor cursor) {
-    TypedefInfo info;
-    info.newName = getCursorSpelling(cursor);
-    info.originalType = getCursorType(cursor);
-    info.comment = getComment(cursor);
+std::future<HeaderAnalyzer> HeaderAnalyzer::analyzeAsync(const std::string& filename) {
+    return analyzeAsync(filename, Options());
+}
 
-    CXType type = clang_getCursorType(cursor);
-    if (clang_isConstQualifiedType(type)) info.qualifiers += "const ";
-    if (clang_isVolatileQualifiedType(type)) info.qualifiers += "volatile ";
+std::future<HeaderAnalyzer> HeaderAnalyzer::analyzeAsync(const std::string& filename, const Options& options) {
+    auto promise = std::make_shared<std::promise<HeaderAnalyzer>>();
+    std::future<HeaderAnalyzer> future = promise->get_future();
+    analyzeAsync(filename, options, [promise](std::unique_ptr<HeaderAnalyzer> analyzer, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(*analyzer));
+        }
+    });
+    return future;
+}
 
-    return info;
+void HeaderAnalyzer::analyzeAsync(const std::string& filename, const Options& options, Callback callback) {
+    BoundedExecutor::shared().submit([filename, options, callback = std::move(callback)]() {
+        std::unique_ptr<HeaderAnalyzer> analyzer;
+        std::exception_ptr error;
+        try {
+            analyzer.reset(new HeaderAnalyzer(filename, options));
+        } catch (...) {
+            error = std::current_exception();
+        }
+        callback(std::move(analyzer), error);
+    });
 }
 
+const TypeSpellingCache::Statistics& HeaderAnalyzer::getTypeSpellingStatistics() const { return m_typeSpellingStatistics; }
+
 // Implementation of XML conversion methods
-std::string HeaderAnalyzer::enumToXML(const EnumInfo& enumInfo) const {
+std::string HeaderAnalyzer::enumToXML(const EnumInfo& enumInfo) {
     std::ostringstream xml;
     xml << "    <enum name=\"" << enumInfo.name << "\" underlying-type=\"" << enumInfo.underlyingType << "\">\n";
     if (!enumInfo.comment.empty()) {
@@ -290,22 +161,31 @@ std::string HeaderAnalyzer::enumToXML(const EnumInfo& enumInfo) const {
     return xml.str();
 }
 
-std::string HeaderAnalyzer::structToXML(const StructInfo& structInfo) const {
+std::string HeaderAnalyzer::structToXML(const StructInfo& structInfo) {
     std::ostringstream xml;
-    xml << "    <struct name=\"" << structInfo.name << "\">\n";
+    xml << "    <struct name=\"" << structInfo.name << "\" size=\"" << structInfo.size << "\" alignment=\"" << structInfo.alignment << "\"";
+    // Only written for the few structs that are not tagged declarations at file scope
+    if (!structInfo.tagged) {
+        xml << " tagged=\"false\"";
+    }
+    if (!structInfo.parent.empty()) {
+        xml << " parent=\"" << structInfo.parent << "\"";
+    }
+    xml << ">\n";
     if (!structInfo.comment.empty()) {
         xml << "      <comment>" << structInfo.comment << "</comment>\n";
     }
     xml << "      <members>\n";
     for (const auto& member : structInfo.members) {
-        xml << "        <member name=\"" << member.name << "\" type=\"" << member.type << "\" bitfield-width=\"" << member.bitfieldWidth << "\"/>\n";
+        xml << "        <member name=\"" << member.name << "\" type=\"" << member.type << "\" bitfield-width=\"" << member.bitfieldWidth
+            << "\" offset=\"" << member.offset << "\" size=\"" << member.size << "\" canonical-type=\"" << member.canonicalType << "\"/>\n";
     }
     xml << "      </members>\n";
     xml << "    </struct>\n";
     return xml.str();
 }
 
-std::string HeaderAnalyzer::functionToXML(const FunctionInfo& functionInfo) const {
+std::string HeaderAnalyzer::functionToXML(const FunctionInfo& functionInfo) {
     std::ostringstream xml;
     xml << "    <function name=\"" << functionInfo.name << "\" return-type=\"" << functionInfo.returnType << "\" is-variadic=\"" << (functionInfo.isVariadic ? "true" : "false") << "\">\n";
     if (!functionInfo.comment.empty()) {
@@ -323,7 +203,7 @@ std::string HeaderAnalyzer::functionToXML(const FunctionInfo& functionInfo) cons
     return xml.str();
 }
 
-std::string HeaderAnalyzer::variableToXML(const VariableInfo& variableInfo) const {
+std::string HeaderAnalyzer::variableToXML(const VariableInfo& variableInfo) {
     std::ostringstream xml;
     xml << "    <variable name=\"" << variableInfo.name << "\" type=\"" << variableInfo.type << "\" value=\"" << variableInfo.value << "\" storage-class=\"" << variableInfo.storageClass << "\">\n";
     if (!variableInfo.arrayDimensions.empty()) {
@@ -333,6 +213,9 @@ std::string HeaderAnalyzer::variableToXML(const VariableInfo& variableInfo) cons
         }
         xml << "      </array-dimensions>\n";
     }
+    if (!variableInfo.qualifiers.empty()) {
+        xml << "      <qualifiers>" << variableInfo.qualifiers << "</qualifiers>\n";
+    }
     if (!variableInfo.comment.empty()) {
         xml << "      <comment>" << variableInfo.comment << "</comment>\n";
     }
@@ -340,7 +223,7 @@ std::string HeaderAnalyzer::variableToXML(const VariableInfo& variableInfo) cons
     return xml.str();
 }
 
-std::string HeaderAnalyzer::typedefToXML(const TypedefInfo& typedefInfo) const {
+std::string HeaderAnalyzer::typedefToXML(const TypedefInfo& typedefInfo) {
     std::ostringstream xml;
     xml << "    <typedef new-name=\"" << typedefInfo.newName << "\" original-type=\"" << typedefInfo.originalType << "\">\n";
     if (!typedefInfo.qualifiers.empty()) {
@@ -353,59 +236,156 @@ std::string HeaderAnalyzer::typedefToXML(const TypedefInfo& typedefInfo) const {
     return xml.str();
 }
 
-// Main function to write HeaderAnalyzer info to XML
-void HeaderAnalyzer::writeToXML(const std::string& outputFilename) const {
-    std::ostringstream xmlStream;
+// Appends the five declaration sections to xml, handing it to the writer in chunks so that
+// compressing and writing earlier chunks overlaps with formatting the later ones
+void HeaderAnalyzer::writeSectionsXML(std::string& xml, CompressedFileWriter& outFile) const {
+    XMLFormatter formatter(xml, outFile);
+    HeaderVisitor<XMLFormatter>(formatter).visit(*this);
+}
 
-    // Start XML document
-    xmlStream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    xmlStream << "<header>\n";
+std::vector<HeaderAnalyzer::XMLChunk> HeaderAnalyzer::splitSectionsXML() const {
+    const size_t sizes[SectionCount] = {m_enums.size(), m_typedefs.size(), m_structs.size(), m_variables.size(), m_functions.size()};
+    std::vector<XMLChunk> chunks;
+    for (size_t section = 0; section < SectionCount; ++section) {
+        // An empty section still gets a chunk for its opening and closing tags
+        size_t begin = 0;
+        do {
+            size_t end = std::min(begin + kEntriesPerChunk, sizes[section]);
+            chunks.push_back({section, begin, end});
+            begin = end;
+        } while (begin < sizes[section]);
+    }
+    return chunks;
+}
+
+std::string HeaderAnalyzer::chunkToXML(const XMLChunk& chunk) const {
+    const size_t sizes[SectionCount] = {m_enums.size(), m_typedefs.size(), m_structs.size(), m_variables.size(), m_functions.size()};
+    const std::string name = kSectionNames[chunk.section];
+    std::string xml;
+    if (chunk.begin == 0) {
+        xml += "  <" + name + ">\n";
+    }
+    for (size_t i = chunk.begin; i < chunk.end; ++i) {
+        switch (chunk.section) {
+            case EnumSection: xml += enumToXML(m_enums[i]); break;
+            case TypedefSection: xml += typedefToXML(m_typedefs[i]); break;
+            case StructSection: xml += structToXML(m_structs[i]); break;
+            case VariableSection: xml += variableToXML(m_variables[i]); break;
+            case FunctionSection: xml += functionToXML(m_functions[i]); break;
+        }
+    }
+    if (chunk.end == sizes[chunk.section]) {
+        xml += "  </" + name + ">\n";
+    }
+    return xml;
+}
+
+// Formats the sections on several threads. The calling thread writes the chunks in order as
+// they become ready, batching consecutive ready chunks into one vectored write. Formatting
+// threads stay at most a bounded number of chunks ahead of the writer.
+void HeaderAnalyzer::writeSectionsXML(std::string& xml, CompressedFileWriter& outFile, size_t threads) const {
+    size_t entries = m_enums.size() + m_typedefs.size() + m_structs.size() + m_variables.size() + m_functions.size();
+    if (threads <= 1 || entries < 2 * kEntriesPerChunk) {
+        writeSectionsXML(xml, outFile);
+        return;
+    }
 
-    // Write Enums
-    xmlStream << "  <enums>\n";
-    for (const auto& enumInfo : getEnums()) {
-        xmlStream << enumToXML(enumInfo);
+    std::vector<XMLChunk> chunks = splitSectionsXML();
+    threads = std::min(threads, chunks.size());
+    const size_t window = threads * kChunksInFlightPerThread;
+
+    outFile.write(std::move(xml));
+    xml.clear();
+
+    std::vector<std::string> formatted(chunks.size());
+    std::vector<bool> ready(chunks.size(), false);
+    size_t written = 0;
+    std::mutex mutex;
+    std::condition_variable readyChanged;
+    std::condition_variable writtenChanged;
+    std::atomic<size_t> next{0};
+
+    auto format = [&]() {
+        for (;;) {
+            size_t index = next++;
+            if (index >= chunks.size()) {
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                writtenChanged.wait(lock, [&] { return index < written + window; });
+            }
+            TraceRecorder::Span span("serialize-chunk");
+            std::string text = chunkToXML(chunks[index]);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                formatted[index] = std::move(text);
+                ready[index] = true;
+            }
+            readyChanged.notify_one();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back(format);
     }
-    xmlStream << "  </enums>\n";
 
-    // Write Typedefs
-    xmlStream << "  <typedefs>\n";
-    for (const auto& typedefInfo : getTypedefs()) {
-        xmlStream << typedefToXML(typedefInfo);
+    std::vector<std::string> batch;
+    while (written < chunks.size()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            readyChanged.wait(lock, [&] { return ready[written]; });
+            for (size_t i = written; i < chunks.size() && ready[i]; ++i) {
+                batch.push_back(std::move(formatted[i]));
+            }
+        }
+        size_t count = batch.size();
+        outFile.write(std::move(batch));
+        batch.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written += count;
+        }
+        writtenChanged.notify_all();
     }
-    xmlStream << "  </typedefs>\n";
 
-    // Write Structs
-    xmlStream << "  <structs>\n";
-    for (const auto& structInfo : getStructs()) {
-        xmlStream << structToXML(structInfo);
+    for (auto& worker : workers) {
+        worker.join();
     }
-    xmlStream << "  </structs>\n";
+}
+
+// Main function to write HeaderAnalyzer info to XML
+bool HeaderAnalyzer::writeToXML(const std::string& outputFilename, Compression compression) const {
+    return writeToXML(outputFilename, compression, 1);
+}
 
-    // Write Variables
-    xmlStream << "  <variables>\n";
-    for (const auto& variableInfo : getVariables()) {
-        xmlStream << variableToXML(variableInfo);
+bool HeaderAnalyzer::writeToXML(const std::string& outputFilename, Compression compression, size_t threads) const {
+    TraceRecorder::Span span("serialize", m_filename);
+    CompressedFileWriter outFile(outputFilename, compression);
+    if (!outFile.isOpen()) {
+        std::cerr << outFile.getError() << std::endl;
+        return false;
     }
-    xmlStream << "  </variables>\n";
 
-    // Write Functions
-    xmlStream << "  <functions>\n";
-    for (const auto& functionInfo : getFunctions()) {
-        xmlStream << functionToXML(functionInfo);
+    // Start XML document
+    std::string xml;
+    xml += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    xml += "<header>\n";
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
     }
-    xmlStream << "  </functions>\n";
+    writeSectionsXML(xml, outFile, threads);
 
     // End XML document
-    xmlStream << "</header>\n";
-
-    // Write to file
-    std::ofstream outFile(outputFilename);
-    if (outFile.is_open()) {
-        outFile << xmlStream.str();
-        outFile.close();
-        // std::cout << "XML written to " << outputFilename << std::endl;
-    } else {
-        std::cerr << "Error opening file for writing: " << outputFilename << std::endl;
+    xml += "</header>\n";
+    outFile.write(std::move(xml));
+
+    if (!outFile.close()) {
+        std::cerr << outFile.getError() << std::endl;
+        return false;
     }
+    return true;
 }
@@ -1,9 +1,15 @@
 #pragma once
 
 #include <clang-c/Index.h>
+#include "CompressedFile.h"
+#include "DeclarationFilter.h"
+#include "TypeSpellingCache.h"
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
 #include <string>
 #include <vector>
-#include <unordered_set>
 
 /**
  * @class HeaderAnalyzer
@@ -33,24 +39,33 @@ public:
      * @struct StructMember
      * @brief Represents a member of a structure.
      * 
-     * This structure contains the name, type, and bitfield width of a member within a struct.
+     * This structure contains the name, type, and bitfield width of a member within a struct,
+     * and its layout as reported by clang for the analyzed target.
      */
     struct StructMember {
         std::string name; /**< The name of the structure member. */
         std::string type; /**< The type of the structure member. */
         int bitfieldWidth; /**< The width of the bitfield, if applicable. */
+        long long offset; /**< The offset from the start of the structure in bits, -1 if unknown. */
+        long long size; /**< The size of the member type in bytes, -1 if unknown. */
+        std::string canonicalType; /**< The type with all typedefs resolved (e.g., "unsigned int" for uint32_t). */
     };
 
     /**
      * @struct StructInfo
      * @brief Represents information about a structure type.
      * 
-     * This structure includes the name of the struct, its members, and an optional comment.
+     * This structure includes the name of the struct, its members, an optional comment, its
+     * size and alignment as reported by clang for the analyzed target, and how it is named.
      */
     struct StructInfo {
         std::string name; /**< The name of the structure. */
+        bool tagged; /**< False if the struct has no tag and is named by a typedef, as in typedef struct { ... } Name. */
+        std::string parent; /**< The struct or union the declaration is nested in, empty at file scope. */
         std::vector<StructMember> members; /**< A vector of members belonging to the structure. */
         std::string comment; /**< An optional comment describing the structure. */
+        long long size; /**< The size of the structure in bytes for the analyzed target, -1 if unknown. */
+        long long alignment; /**< The alignment of the structure in bytes for the analyzed target, -1 if unknown. */
     };
 
     /**
@@ -100,57 +115,244 @@ public:
         std::string comment; /**< An optional comment describing the typedef. */
     };
 
+    /**
+     * @struct UnsavedFile
+     * @brief Represents an in-memory file that libclang reads instead of the file system.
+     */
+    struct UnsavedFile {
+        std::string filename; /**< The path the file is known by, as resolved by #include directives. */
+        std::string contents; /**< The contents of the file. */
+    };
+
+    /**
+     * @struct Options
+     * @brief Controls how a header file is parsed.
+     */
+    struct Options {
+        std::vector<std::string> arguments; /**< Extra command-line arguments passed to clang (e.g., "-DFOO", "-Iinclude"). */
+        std::vector<UnsavedFile> unsavedFiles; /**< In-memory files that take precedence over files on disk. */
+        DeclarationFilter filter; /**< Selects the declarations to extract, all of them by default. */
+    };
+
+    /**
+     * @brief Callback invoked when an asynchronous analysis finishes.
+     *
+     * On success the analyzer is set and the exception is null; on failure the analyzer is null
+     * and the exception holds the error thrown by the constructor.
+     */
+    using Callback = std::function<void(std::unique_ptr<HeaderAnalyzer> analyzer, std::exception_ptr error)>;
+
     /**
      * @brief Constructs a HeaderAnalyzer for the specified header file.
+     *
+     * The header is parsed and all declarations are extracted during construction. The clang
+     * translation unit and index are disposed as soon as extraction finishes, so the analyzer
+     * only keeps the extracted data.
+     *
      * @param filename The path to the header file to analyze.
      */
     HeaderAnalyzer(const std::string& filename);
 
+    /**
+     * @brief Constructs a HeaderAnalyzer for the specified header file using the given options.
+     * @param filename The path to the header file to analyze.
+     * @param options The options controlling how the header is parsed.
+     */
+    HeaderAnalyzer(const std::string& filename, const Options& options);
+
+    /**
+     * @brief Constructs a HeaderAnalyzer for an in-memory header without reading it from disk.
+     *
+     * Included files are read from disk unless they are provided in options.unsavedFiles.
+     * No file with the given name needs to exist.
+     *
+     * @param filename The name of the header, used to resolve relative includes.
+     * @param contents The contents of the header.
+     */
+    HeaderAnalyzer(const std::string& filename, const std::string& contents);
+
+    /**
+     * @brief Constructs a HeaderAnalyzer for an in-memory header using the given options.
+     * @param filename The name of the header, used to resolve relative includes.
+     * @param contents The contents of the header.
+     * @param options The options controlling how the header is parsed.
+     */
+    HeaderAnalyzer(const std::string& filename, const std::string& contents, const Options& options);
+
+    HeaderAnalyzer(const HeaderAnalyzer&) = default;
+    HeaderAnalyzer(HeaderAnalyzer&&) = default;
+    HeaderAnalyzer& operator=(const HeaderAnalyzer&) = default;
+    HeaderAnalyzer& operator=(HeaderAnalyzer&&) = default;
+
     /**
      * @brief Destructor for the HeaderAnalyzer.
      */
-    ~HeaderAnalyzer();
+    ~HeaderAnalyzer() = default;
+
+    /**
+     * @brief Analyzes a header file with the default Options on the shared bounded executor.
+     *
+     * Parsing failures are reported through the future instead of being thrown by this call.
+     *
+     * @param filename The path to the header file to analyze.
+     * @return A future that holds the analyzer, or the exception thrown while analyzing.
+     */
+    static std::future<HeaderAnalyzer> analyzeAsync(const std::string& filename);
+
+    /**
+     * @brief Analyzes a header file on the shared bounded executor.
+     *
+     * Parsing failures are reported through the future instead of being thrown by this call.
+     *
+     * @param filename The path to the header file to analyze.
+     * @param options The options controlling how the header is parsed.
+     * @return A future that holds the analyzer, or the exception thrown while analyzing.
+     */
+    static std::future<HeaderAnalyzer> analyzeAsync(const std::string& filename, const Options& options);
+
+    /**
+     * @brief Analyzes a header file on the shared bounded executor and invokes a callback.
+     *
+     * The callback runs on an executor thread and must not throw. This call blocks only while
+     * the executor queue is full. The callback must not call analyzeAsync itself: once every
+     * executor thread is blocked waiting for room in the queue, none is left to make room.
+     *
+     * @param filename The path to the header file to analyze.
+     * @param options The options controlling how the header is parsed.
+     * @param callback The callback receiving the analyzer or the error.
+     */
+    static void analyzeAsync(const std::string& filename, const Options& options, Callback callback);
+
+    /**
+     * @brief Rebuilds analyzer results from a file written by writeToXML, without libclang.
+     *
+     * The file is read with a single-pass parser for exactly the schema writeToXML emits and may
+     * be gzip or zstd compressed. This is defined in XMLLoader.cpp, which together with
+     * CompressedFile.cpp does not depend on libclang. Files written before variable qualifiers
+     * were recorded load with empty qualifiers, and files written before struct layout was
+     * recorded load with a layout of -1.
+     *
+     * @param filename The path of the XML file to load.
+     * @return An analyzer holding the declarations stored in the file.
+     * @throws std::runtime_error If the file cannot be read or does not match the schema.
+     */
+    static HeaderAnalyzer loadFromXML(const std::string& filename);
+
+    /**
+     * @brief Builds an analyzer from declarations obtained without parsing the header.
+     *
+     * Used for declarations loaded from XML, received from a worker process or split across
+     * configurations. The type spelling statistics and translation unit memory are left at zero.
+     *
+     * @param filename The path of the header, or of the file the declarations were read from.
+     * @param enums The enumerations, in declaration order.
+     * @param structs The structures, in declaration order.
+     * @param functions The functions, in declaration order.
+     * @param variables The variables, in declaration order.
+     * @param typedefs The typedefs, in declaration order.
+     * @return An analyzer holding the given declarations.
+     */
+    static HeaderAnalyzer fromDeclarations(std::string filename, std::vector<EnumInfo> enums,
+                                           std::vector<StructInfo> structs, std::vector<FunctionInfo> functions,
+                                           std::vector<VariableInfo> variables, std::vector<TypedefInfo> typedefs);
+
+    /**
+     * @brief Retrieves the path of the analyzed header, or of the XML file it was loaded from.
+     * @return A constant reference to the file name.
+     */
+    const std::string& getFilename() const { return m_filename; }
 
     /**
      * @brief Retrieves a list of enumerations found in the analyzed header file.
      * @return A constant reference to a vector of EnumInfo structures.
      */
-    const std::vector<EnumInfo>& getEnums() const;
+    const std::vector<EnumInfo>& getEnums() const { return m_enums; }
 
     /**
      * @brief Retrieves a list of structures found in the analyzed header file.
      * @return A constant reference to a vector of StructInfo structures.
      */
-    const std::vector<StructInfo>& getStructs() const;
+    const std::vector<StructInfo>& getStructs() const { return m_structs; }
 
     /**
      * @brief Retrieves a list of functions found in the analyzed header file.
      * @return A constant reference to a vector of FunctionInfo structures.
      */
-    const std::vector<FunctionInfo>& getFunctions() const;
+    const std::vector<FunctionInfo>& getFunctions() const { return m_functions; }
 
     /**
      * @brief Retrieves a list of variables found in the analyzed header file.
      * @return A constant reference to a vector of VariableInfo structures.
      */
-    const std::vector<VariableInfo>& getVariables() const;
+    const std::vector<VariableInfo>& getVariables() const { return m_variables; }
 
     /**
      * @brief Retrieves a list of typedefs found in the analyzed header file.
      * @return A constant reference to a vector of TypedefInfo structures.
      */
-    const std::vector<TypedefInfo>& getTypedefs() const;
+    const std::vector<TypedefInfo>& getTypedefs() const { return m_typedefs; }
+
+    /**
+     * @brief Retrieves how often type spellings were requested and how often libclang was called.
+     *
+     * Type spellings are memoized per translation unit, so the difference between the two counts
+     * is the number of clang_getTypeSpelling calls and string allocations that were avoided.
+     *
+     * @return A constant reference to the type spelling statistics.
+     */
+    const TypeSpellingCache::Statistics& getTypeSpellingStatistics() const;
+
+    /**
+     * @brief Retrieves the memory the translation unit held before it was disposed.
+     *
+     * This is the sum of the clang_getCXTUResourceUsage entries, taken after extraction, and
+     * therefore the memory the analyzer does not keep alive.
+     *
+     * @return The bytes libclang reported, 0 for an analyzer that did not parse a header.
+     */
+    size_t getTranslationUnitMemory() const { return m_translationUnitMemory; }
 
     /**
      * @brief Writes the analyzed information to an XML file.
+     *
+     * With compression enabled, the XML is compressed on a separate pipeline stage while it is
+     * being formatted. CompressedFileReader reads the result back transparently.
+     *
+     * @param outputFilename The name of the output XML file.
+     * @param compression The compression to apply, by default chosen from the extension (".gz", ".zst").
+     * @return False if the file could not be opened or written; the error is printed to std::cerr.
+     */
+    bool writeToXML(const std::string& outputFilename, Compression compression = Compression::Auto) const;
+
+    /**
+     * @brief Writes the analyzed information to an XML file, formatting it on several threads.
+     *
+     * The declarations are split into chunks of consecutive entries of one section. Chunks are
+     * formatted concurrently into separate buffers and written in order as soon as they are
+     * ready, so the output is byte-identical to the single-threaded overload. Only a bounded
+     * number of formatted chunks is held in memory at a time.
+     *
      * @param outputFilename The name of the output XML file.
+     * @param compression The compression to apply, Auto chooses it from the extension.
+     * @param threads The number of formatting threads, 0 for one per hardware thread and 1 to
+     *                format on the calling thread.
+     * @return False if the file could not be opened or written; the error is printed to std::cerr.
      */
-    void writeToXML(const std::string& outputFilename) const;
+    bool writeToXML(const std::string& outputFilename, Compression compression, size_t threads) const;
+
+    /**
+     * @brief Appends the enums, typedefs, structs, variables and functions elements to a document.
+     *
+     * This is the body of writeToXML, for documents that embed the declarations of several
+     * analyzers. The buffer is flushed to the file whenever it grows past the output chunk size.
+     *
+     * @param xml The buffer holding the part of the document not yet written.
+     * @param outFile The file the document is written to.
+     */
+    void writeSectionsXML(std::string& xml, CompressedFileWriter& outFile) const;
 
 private:
     std::string m_filename;
-    CXIndex m_index;
-    CXTranslationUnit m_translationUnit;
 
     std::vector<EnumInfo> m_enums;
     std::vector<StructInfo> m_structs;
@@ -158,31 +360,35 @@ private:
     std::vector<VariableInfo> m_variables;
     std::vector<TypedefInfo> m_typedefs;
 
-    // For tracking processed names
-    std::unordered_set<std::string> m_processedNames;
-
-    static CXChildVisitResult visitNode(CXCursor cursor, CXCursor parent, CXClientData client_data);
-    static std::string getCursorSpelling(CXCursor cursor);
-    static std::string getCursorType(CXCursor cursor);
-    static std::string getCursorResultType(CXCursor cursor);
-    static std::string getComment(CXCursor cursor);
-    static EnumInfo processEnum(CXCursor cursor);
-    static StructInfo processStruct(CXCursor cursor);
-    static FunctionInfo processFunction(CXCursor cursor);
-    static VariableInfo processVariable(CXCursor cursor);
-    static TypedefInfo processTypedef(CXCursor cursor);
-
-    // Helper function declarations for variable info
-    static VariableInfo initializeVariableInfo(CXCursor cursor);
-    static std::string getStorageClass(CXCursor cursor);
-    static std::string getTypeQualifiers(CXCursor cursor);
-    static std::vector<int> getArrayDimensions(CXCursor cursor);
-    static std::string evaluateVariable(CXCursor cursor);
+    // Type spelling statistics of the traversal
+    TypeSpellingCache::Statistics m_typeSpellingStatistics;
+
+    // Memory of the translation unit, measured just before it was disposed
+    size_t m_translationUnitMemory = 0;
+
+    // Used by fromDeclarations to build an analyzer without parsing a header
+    HeaderAnalyzer() = default;
+
+    void analyze(const Options& options, const std::string* contents);
+
+    // The HeaderVisitor policies of analyze and writeToXML
+    struct Extractor;
+    struct XMLFormatter;
+
+    // A range of entries of one section, formatted independently of the other chunks
+    struct XMLChunk {
+        size_t section; // Index of the section, in output order
+        size_t begin;
+        size_t end;
+    };
 
     // XML conversion methods
-    std::string enumToXML(const EnumInfo& enumInfo) const;
-    std::string structToXML(const StructInfo& structInfo) const;
-    std::string functionToXML(const FunctionInfo& functionInfo) const;
-    std::string variableToXML(const VariableInfo& variableInfo) const;
-    std::string typedefToXML(const TypedefInfo& typedefInfo) const;
+    void writeSectionsXML(std::string& xml, CompressedFileWriter& outFile, size_t threads) const;
+    std::vector<XMLChunk> splitSectionsXML() const;
+    std::string chunkToXML(const XMLChunk& chunk) const;
+    static std::string enumToXML(const EnumInfo& enumInfo);
+    static std::string structToXML(const StructInfo& structInfo);
+    static std::string functionToXML(const FunctionInfo& functionInfo);
+    static std::string variableToXML(const VariableInfo& variableInfo);
+    static std::string typedefToXML(const TypedefInfo& typedefInfo);
 };
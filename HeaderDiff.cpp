@@ -0,0 +1,344 @@
+#include "HeaderDiff.h"
+#include "DeclarationKeys.h"
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <algorithm>
+
+namespace {
+
+// 64-bit FNV-1a over length-prefixed fields, so that ("ab", "c") and ("a", "bc") hash differently.
+// Integers are fed byte by byte in little-endian order to keep fingerprints stable across hosts.
+class Fingerprinter {
+public:
+    Fingerprinter& add(const std::string& value) {
+        add(static_cast<long long>(value.size()));
+        for (unsigned char c : value) {
+            addByte(c);
+        }
+        return *this;
+    }
+
+    Fingerprinter& add(long long value) {
+        unsigned long long bits = static_cast<unsigned long long>(value);
+        for (int i = 0; i < 8; ++i) {
+            addByte(static_cast<unsigned char>(bits >> (i * 8)));
+        }
+        return *this;
+    }
+
+    uint64_t value() const { return m_hash; }
+
+private:
+    uint64_t m_hash = 14695981039346656037ULL;
+
+    void addByte(unsigned char byte) {
+        m_hash ^= byte;
+        m_hash *= 1099511628211ULL;
+    }
+};
+
+void addField(std::vector<HeaderDiff::FieldChange>& fields, const std::string& field,
+              const std::string& before, const std::string& after) {
+    if (before != after) {
+        fields.push_back({field, before, after});
+    }
+}
+
+std::string dimensionsToString(const std::vector<int>& dimensions) {
+    std::string result;
+    for (int dim : dimensions) {
+        result += "[" + std::to_string(dim) + "]";
+    }
+    return result;
+}
+
+template <typename Info, typename NameFn, typename CompareFn>
+void diffDeclarations(const std::vector<Info>& before, const std::vector<Info>& after,
+                      HeaderDiff::DeclarationKind kind, NameFn getName, CompareFn compare,
+                      std::vector<HeaderDiff::Change>& changes) {
+    std::vector<std::string> beforeKeys = makeDeclarationKeys(before, getName);
+    std::vector<std::string> afterKeys = makeDeclarationKeys(after, getName);
+
+    std::unordered_map<std::string, size_t> beforeIndex;
+    beforeIndex.reserve(before.size());
+    for (size_t i = 0; i < before.size(); ++i) {
+        beforeIndex.emplace(beforeKeys[i], i);
+    }
+
+    std::vector<bool> matched(before.size(), false);
+    std::vector<HeaderDiff::Change> addedOrChanged;
+    for (size_t i = 0; i < after.size(); ++i) {
+        auto it = beforeIndex.find(afterKeys[i]);
+        if (it == beforeIndex.end()) {
+            addedOrChanged.push_back({kind, HeaderDiff::ChangeType::Added, getName(after[i]), {}});
+            continue;
+        }
+        matched[it->second] = true;
+        const Info& old = before[it->second];
+        if (HeaderDiff::fingerprint(old) != HeaderDiff::fingerprint(after[i])) {
+            addedOrChanged.push_back({kind, HeaderDiff::ChangeType::Changed, getName(after[i]), compare(old, after[i])});
+        }
+    }
+
+    for (size_t i = 0; i < before.size(); ++i) {
+        if (!matched[i]) {
+            changes.push_back({kind, HeaderDiff::ChangeType::Removed, getName(before[i]), {}});
+        }
+    }
+    for (auto& change : addedOrChanged) {
+        changes.push_back(std::move(change));
+    }
+}
+
+// Compares two named, ordered lists (enumerators, members). Entries are matched by the keys of
+// makeDeclarationKeys, so that anonymous members (all named "") pair up by occurrence rather than all with
+// the first one. If the same keys appear in a different order, the order itself is a change.
+template <typename Entry, typename NameFn, typename ValueFn>
+void compareNamedList(std::vector<HeaderDiff::FieldChange>& fields, const std::string& prefix,
+                      const std::vector<Entry>& before, const std::vector<Entry>& after,
+                      NameFn getName, ValueFn getValue) {
+    std::vector<std::string> beforeKeys = makeDeclarationKeys(before, getName);
+    std::vector<std::string> afterKeys = makeDeclarationKeys(after, getName);
+
+    std::unordered_map<std::string, size_t> beforeIndex;
+    beforeIndex.reserve(before.size());
+    for (size_t i = 0; i < before.size(); ++i) {
+        beforeIndex.emplace(beforeKeys[i], i);
+    }
+
+    size_t initialCount = fields.size();
+    std::vector<bool> matched(before.size(), false);
+    bool sameOrder = before.size() == after.size();
+    for (size_t i = 0; i < after.size(); ++i) {
+        auto it = beforeIndex.find(afterKeys[i]);
+        if (it == beforeIndex.end()) {
+            fields.push_back({prefix + ":" + afterKeys[i], "", getValue(after[i])});
+            sameOrder = false;
+            continue;
+        }
+        matched[it->second] = true;
+        sameOrder = sameOrder && it->second == i;
+        addField(fields, prefix + ":" + afterKeys[i], getValue(before[it->second]), getValue(after[i]));
+    }
+    for (size_t i = 0; i < before.size(); ++i) {
+        if (!matched[i]) {
+            fields.push_back({prefix + ":" + beforeKeys[i], getValue(before[i]), ""});
+        }
+    }
+
+    if (!sameOrder && fields.size() == initialCount) {
+        std::string beforeOrder, afterOrder;
+        for (const auto& key : beforeKeys) beforeOrder += (beforeOrder.empty() ? "" : ",") + key;
+        for (const auto& key : afterKeys) afterOrder += (afterOrder.empty() ? "" : ",") + key;
+        addField(fields, prefix + "-order", beforeOrder, afterOrder);
+    }
+}
+
+const char* kindToTag(HeaderDiff::DeclarationKind kind) {
+    switch (kind) {
+        case HeaderDiff::DeclarationKind::Enum: return "enum";
+        case HeaderDiff::DeclarationKind::Struct: return "struct";
+        case HeaderDiff::DeclarationKind::Function: return "function";
+        case HeaderDiff::DeclarationKind::Variable: return "variable";
+        case HeaderDiff::DeclarationKind::Typedef: return "typedef";
+    }
+    return "unknown";
+}
+
+const char* changeTypeToString(HeaderDiff::ChangeType type) {
+    switch (type) {
+        case HeaderDiff::ChangeType::Added: return "added";
+        case HeaderDiff::ChangeType::Removed: return "removed";
+        case HeaderDiff::ChangeType::Changed: return "changed";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+HeaderDiff::HeaderDiff(const HeaderAnalyzer& before, const HeaderAnalyzer& after) {
+    // Same section order as HeaderAnalyzer::writeToXML
+    diffDeclarations(before.getEnums(), after.getEnums(), DeclarationKind::Enum,
+                     [](const HeaderAnalyzer::EnumInfo& info) -> const std::string& { return info.name; },
+                     &HeaderDiff::compareEnums, m_changes);
+    diffDeclarations(before.getTypedefs(), after.getTypedefs(), DeclarationKind::Typedef,
+                     [](const HeaderAnalyzer::TypedefInfo& info) -> const std::string& { return info.newName; },
+                     &HeaderDiff::compareTypedefs, m_changes);
+    diffDeclarations(before.getStructs(), after.getStructs(), DeclarationKind::Struct,
+                     [](const HeaderAnalyzer::StructInfo& info) -> const std::string& { return info.name; },
+                     &HeaderDiff::compareStructs, m_changes);
+    diffDeclarations(before.getVariables(), after.getVariables(), DeclarationKind::Variable,
+                     [](const HeaderAnalyzer::VariableInfo& info) -> const std::string& { return info.name; },
+                     &HeaderDiff::compareVariables, m_changes);
+    diffDeclarations(before.getFunctions(), after.getFunctions(), DeclarationKind::Function,
+                     [](const HeaderAnalyzer::FunctionInfo& info) -> const std::string& { return info.name; },
+                     &HeaderDiff::compareFunctions, m_changes);
+}
+
+const std::vector<HeaderDiff::Change>& HeaderDiff::getChanges() const { return m_changes; }
+bool HeaderDiff::empty() const { return m_changes.empty(); }
+
+uint64_t HeaderDiff::fingerprint(const HeaderAnalyzer::EnumInfo& info) {
+    Fingerprinter fp;
+    fp.add(info.name).add(info.underlyingType).add(static_cast<long long>(info.enumerators.size()));
+    for (const auto& enumerator : info.enumerators) {
+        fp.add(enumerator.first).add(enumerator.second);
+    }
+    return fp.value();
+}
+
+uint64_t HeaderDiff::fingerprint(const HeaderAnalyzer::StructInfo& info) {
+    Fingerprinter fp;
+    fp.add(info.name).add(info.tagged ? 1 : 0).add(info.parent);
+    fp.add(info.size).add(info.alignment).add(static_cast<long long>(info.members.size()));
+    for (const auto& member : info.members) {
+        fp.add(member.name).add(member.type).add(static_cast<long long>(member.bitfieldWidth));
+        fp.add(member.offset).add(member.size).add(member.canonicalType);
+    }
+    return fp.value();
+}
+
+uint64_t HeaderDiff::fingerprint(const HeaderAnalyzer::FunctionInfo& info) {
+    Fingerprinter fp;
+    fp.add(info.name).add(info.returnType).add(static_cast<long long>(info.parameters.size()));
+    for (const auto& param : info.parameters) {
+        fp.add(param.first).add(param.second);
+    }
+    fp.add(info.attributes).add(static_cast<long long>(info.isVariadic));
+    return fp.value();
+}
+
+uint64_t HeaderDiff::fingerprint(const HeaderAnalyzer::VariableInfo& info) {
+    Fingerprinter fp;
+    fp.add(info.name).add(info.type).add(info.value).add(info.storageClass).add(info.qualifiers);
+    fp.add(static_cast<long long>(info.arrayDimensions.size()));
+    for (int dim : info.arrayDimensions) {
+        fp.add(static_cast<long long>(dim));
+    }
+    return fp.value();
+}
+
+uint64_t HeaderDiff::fingerprint(const HeaderAnalyzer::TypedefInfo& info) {
+    Fingerprinter fp;
+    fp.add(info.newName).add(info.originalType).add(info.qualifiers);
+    return fp.value();
+}
+
+std::vector<HeaderDiff::FieldChange> HeaderDiff::compareEnums(const HeaderAnalyzer::EnumInfo& before, const HeaderAnalyzer::EnumInfo& after) {
+    std::vector<FieldChange> fields;
+    addField(fields, "underlying-type", before.underlyingType, after.underlyingType);
+    compareNamedList(fields, "enumerator", before.enumerators, after.enumerators,
+                     [](const std::pair<std::string, long long>& e) -> const std::string& { return e.first; },
+                     [](const std::pair<std::string, long long>& e) { return std::to_string(e.second); });
+    return fields;
+}
+
+std::vector<HeaderDiff::FieldChange> HeaderDiff::compareStructs(const HeaderAnalyzer::StructInfo& before, const HeaderAnalyzer::StructInfo& after) {
+    std::vector<FieldChange> fields;
+    addField(fields, "size", std::to_string(before.size), std::to_string(after.size));
+    addField(fields, "alignment", std::to_string(before.alignment), std::to_string(after.alignment));
+    addField(fields, "tagged", before.tagged ? "true" : "false", after.tagged ? "true" : "false");
+    addField(fields, "parent", before.parent, after.parent);
+    // Layout is part of a member's value, so a member that moves or whose type resolves to a
+    // different canonical type is reported even if its spelling is unchanged
+    compareNamedList(fields, "member", before.members, after.members,
+                     [](const HeaderAnalyzer::StructMember& m) -> const std::string& { return m.name; },
+                     [](const HeaderAnalyzer::StructMember& m) {
+                         std::string value = m.bitfieldWidth >= 0 ? m.type + " : " + std::to_string(m.bitfieldWidth) : m.type;
+                         if (m.canonicalType != m.type && !m.canonicalType.empty()) {
+                             value += " (" + m.canonicalType + ")";
+                         }
+                         return value + ", offset " + std::to_string(m.offset) + ", size " + std::to_string(m.size);
+                     });
+    return fields;
+}
+
+std::vector<HeaderDiff::FieldChange> HeaderDiff::compareFunctions(const HeaderAnalyzer::FunctionInfo& before, const HeaderAnalyzer::FunctionInfo& after) {
+    std::vector<FieldChange> fields;
+    addField(fields, "return-type", before.returnType, after.returnType);
+    addField(fields, "is-variadic", before.isVariadic ? "true" : "false", after.isVariadic ? "true" : "false");
+
+    // Parameters are positional, so they are compared by index rather than by name
+    size_t count = std::max(before.parameters.size(), after.parameters.size());
+    for (size_t i = 0; i < count; ++i) {
+        std::string field = "parameter:" + std::to_string(i);
+        std::string beforeParam = i < before.parameters.size() ? before.parameters[i].second + " " + before.parameters[i].first : "";
+        std::string afterParam = i < after.parameters.size() ? after.parameters[i].second + " " + after.parameters[i].first : "";
+        addField(fields, field, beforeParam, afterParam);
+    }
+
+    addField(fields, "attributes", before.attributes, after.attributes);
+    return fields;
+}
+
+std::vector<HeaderDiff::FieldChange> HeaderDiff::compareVariables(const HeaderAnalyzer::VariableInfo& before, const HeaderAnalyzer::VariableInfo& after) {
+    std::vector<FieldChange> fields;
+    addField(fields, "type", before.type, after.type);
+    addField(fields, "value", before.value, after.value);
+    addField(fields, "storage-class", before.storageClass, after.storageClass);
+    addField(fields, "qualifiers", before.qualifiers, after.qualifiers);
+    addField(fields, "array-dimensions", dimensionsToString(before.arrayDimensions), dimensionsToString(after.arrayDimensions));
+    return fields;
+}
+
+std::vector<HeaderDiff::FieldChange> HeaderDiff::compareTypedefs(const HeaderAnalyzer::TypedefInfo& before, const HeaderAnalyzer::TypedefInfo& after) {
+    std::vector<FieldChange> fields;
+    addField(fields, "original-type", before.originalType, after.originalType);
+    addField(fields, "qualifiers", before.qualifiers, after.qualifiers);
+    return fields;
+}
+
+std::string HeaderDiff::changeToXML(const Change& change) const {
+    std::ostringstream xml;
+    xml << "    <" << kindToTag(change.kind) << " name=\"" << change.name << "\" change=\"" << changeTypeToString(change.type) << "\"";
+    if (change.fields.empty()) {
+        xml << "/>\n";
+        return xml.str();
+    }
+    xml << ">\n";
+    for (const auto& field : change.fields) {
+        xml << "      <field name=\"" << field.field << "\" before=\"" << field.before << "\" after=\"" << field.after << "\"/>\n";
+    }
+    xml << "    </" << kindToTag(change.kind) << ">\n";
+    return xml.str();
+}
+
+void HeaderDiff::writeToXML(const std::string& outputFilename, Compression compression) const {
+    std::ostringstream xmlStream;
+
+    // Start XML document
+    xmlStream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    xmlStream << "<header-diff>\n";
+
+    // Changes are stored grouped by kind, in the same section order as HeaderAnalyzer::writeToXML
+    const std::pair<DeclarationKind, const char*> sections[] = {
+        {DeclarationKind::Enum, "enums"},
+        {DeclarationKind::Typedef, "typedefs"},
+        {DeclarationKind::Struct, "structs"},
+        {DeclarationKind::Variable, "variables"},
+        {DeclarationKind::Function, "functions"},
+    };
+    auto it = m_changes.begin();
+    for (const auto& section : sections) {
+        xmlStream << "  <" << section.second << ">\n";
+        for (; it != m_changes.end() && it->kind == section.first; ++it) {
+            xmlStream << changeToXML(*it);
+        }
+        xmlStream << "  </" << section.second << ">\n";
+    }
+
+    // End XML document
+    xmlStream << "</header-diff>\n";
+
+    // Write to file
+    CompressedFileWriter outFile(outputFilename, compression);
+    if (!outFile.isOpen()) {
+        std::cerr << outFile.getError() << std::endl;
+        return;
+    }
+    outFile.write(xmlStream.str());
+    if (!outFile.close()) {
+        std::cerr << outFile.getError() << std::endl;
+    }
+}
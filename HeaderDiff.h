@@ -0,0 +1,114 @@
+#pragma once
+
+#include "HeaderAnalyzer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class HeaderDiff
+ * @brief Computes the API/ABI differences between two analyzed versions of a header.
+ *
+ * Every declaration is reduced to a stable 64-bit fingerprint of its *Info fields. Declarations
+ * are matched by name, and only pairs whose fingerprints differ are compared field by field, so
+ * the whole diff runs in time linear in the number of declarations.
+ */
+class HeaderDiff {
+public:
+    /**
+     * @enum DeclarationKind
+     * @brief The kind of declaration a change refers to.
+     */
+    enum class DeclarationKind {
+        Enum,
+        Struct,
+        Function,
+        Variable,
+        Typedef
+    };
+
+    /**
+     * @enum ChangeType
+     * @brief Describes how a declaration differs between the two versions.
+     */
+    enum class ChangeType {
+        Added,   /**< The declaration only exists in the newer version. */
+        Removed, /**< The declaration only exists in the older version. */
+        Changed  /**< The declaration exists in both versions but its fingerprint differs. */
+    };
+
+    /**
+     * @struct FieldChange
+     * @brief Represents a single field that differs between two versions of a declaration.
+     */
+    struct FieldChange {
+        std::string field; /**< The name of the field (e.g., "return-type" or "member:flags"). */
+        std::string before; /**< The value in the older version, empty if the field was added. */
+        std::string after; /**< The value in the newer version, empty if the field was removed. */
+    };
+
+    /**
+     * @struct Change
+     * @brief Represents a declaration that was added, removed or changed.
+     */
+    struct Change {
+        DeclarationKind kind; /**< The kind of the declaration. */
+        ChangeType type; /**< How the declaration changed. */
+        std::string name; /**< The name of the declaration. */
+        std::vector<FieldChange> fields; /**< The field-level differences, only set for changed declarations. */
+    };
+
+    /**
+     * @brief Computes the differences between two analyzed header versions.
+     * @param before The analyzer holding the older version of the header.
+     * @param after The analyzer holding the newer version of the header.
+     */
+    HeaderDiff(const HeaderAnalyzer& before, const HeaderAnalyzer& after);
+
+    /**
+     * @brief Retrieves the list of changes, grouped by declaration kind.
+     * @return A constant reference to a vector of Change structures.
+     */
+    const std::vector<Change>& getChanges() const;
+
+    /**
+     * @brief Checks whether the two versions have identical declarations.
+     * @return True if no declaration was added, removed or changed.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Writes the changes to an XML file.
+     * @param outputFilename The name of the output XML file.
+     * @param compression The compression to apply, by default chosen from the extension (".gz", ".zst").
+     */
+    void writeToXML(const std::string& outputFilename, Compression compression = Compression::Auto) const;
+
+    /**
+     * @brief Computes the fingerprint of a declaration.
+     *
+     * Fingerprints cover every field that is part of the API or ABI. Comments are documentation
+     * only and are not included.
+     *
+     * @param info The declaration to fingerprint.
+     * @return A stable 64-bit fingerprint.
+     */
+    static uint64_t fingerprint(const HeaderAnalyzer::EnumInfo& info);
+    static uint64_t fingerprint(const HeaderAnalyzer::StructInfo& info);
+    static uint64_t fingerprint(const HeaderAnalyzer::FunctionInfo& info);
+    static uint64_t fingerprint(const HeaderAnalyzer::VariableInfo& info);
+    static uint64_t fingerprint(const HeaderAnalyzer::TypedefInfo& info);
+
+private:
+    std::vector<Change> m_changes;
+
+    // Field-level comparison of two declarations with different fingerprints
+    static std::vector<FieldChange> compareEnums(const HeaderAnalyzer::EnumInfo& before, const HeaderAnalyzer::EnumInfo& after);
+    static std::vector<FieldChange> compareStructs(const HeaderAnalyzer::StructInfo& before, const HeaderAnalyzer::StructInfo& after);
+    static std::vector<FieldChange> compareFunctions(const HeaderAnalyzer::FunctionInfo& before, const HeaderAnalyzer::FunctionInfo& after);
+    static std::vector<FieldChange> compareVariables(const HeaderAnalyzer::VariableInfo& before, const HeaderAnalyzer::VariableInfo& after);
+    static std::vector<FieldChange> compareTypedefs(const HeaderAnalyzer::TypedefInfo& before, const HeaderAnalyzer::TypedefInfo& after);
+
+    // XML conversion methods
+    std::string changeToXML(const Change& change) const;
+};
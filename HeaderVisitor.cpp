@@ -0,0 +1,157 @@
+#include "HeaderVisitor.h"
+#include <stdexcept>
+
+unsigned HeaderExtractor::declarationKind(CXCursorKind kind) {
+    switch (kind) {
+        case CXCursor_EnumDecl: return DeclarationFilter::Enums;
+        case CXCursor_StructDecl: return DeclarationFilter::Structs;
+        case CXCursor_FunctionDecl: return DeclarationFilter::Functions;
+        case CXCursor_VarDecl: return DeclarationFilter::Variables;
+        case CXCursor_TypedefDecl: return DeclarationFilter::Typedefs;
+        default: return 0;
+    }
+}
+
+CXTranslationUnit HeaderExtractor::parse(CXIndex index, const std::string& filename, const HeaderAnalyzer::Options& options,
+                                         const std::string* contents) {
+    std::vector<const char*> arguments;
+    arguments.reserve(options.arguments.size());
+    for (const auto& argument : options.arguments) {
+        arguments.push_back(argument.c_str());
+    }
+
+    // libclang reads these buffers in place of the files on disk
+    std::vector<CXUnsavedFile> unsavedFiles;
+    unsavedFiles.reserve(options.unsavedFiles.size() + 1);
+    if (contents) {
+        unsavedFiles.push_back({filename.c_str(), contents->data(), static_cast<unsigned long>(contents->size())});
+    }
+    for (const auto& file : options.unsavedFiles) {
+        unsavedFiles.push_back({file.filename.c_str(), file.contents.data(), static_cast<unsigned long>(file.contents.size())});
+    }
+
+    CXTranslationUnit translationUnit;
+    {
+        TraceRecorder::Span span("parse", filename);
+        translationUnit = clang_parseTranslationUnit(
+            index,
+            filename.c_str(), arguments.data(), static_cast<int>(arguments.size()),
+            unsavedFiles.data(), static_cast<unsigned>(unsavedFiles.size()),
+            CXTranslationUnit_None);
+    }
+
+    if (translationUnit == nullptr) {
+        throw std::runtime_error("Unable to parse translation unit.");
+    }
+    return translationUnit;
+}
+
+size_t HeaderExtractor::getTranslationUnitMemory(CXTranslationUnit translationUnit) {
+    CXTUResourceUsage usage = clang_getCXTUResourceUsage(translationUnit);
+    size_t bytes = 0;
+    for (unsigned i = 0; i < usage.numEntries; ++i) {
+        bytes += usage.entries[i].amount;
+    }
+    clang_disposeCXTUResourceUsage(usage);
+    return bytes;
+}
+
+std::string HeaderExtractor::getCursorSpelling(CXCursor cursor) {
+    CXString spelling = clang_getCursorSpelling(cursor);
+    const char* cStr = clang_getCString(spelling);
+    std::string result = cStr ? cStr : ""; // Ensure we return an empty string if null
+    clang_disposeString(spelling);
+    return result;
+}
+
+// A struct without a tag takes the name of its typedef. Only the USR tells the two apart in both
+// C and C++: it ends in "@S@Name" for struct Name and in "@SA@Name" for typedef struct { } Name.
+bool HeaderExtractor::hasTag(CXCursor cursor, const std::string& name) {
+    CXString usr = clang_getCursorUSR(cursor);
+    const char* cStr = clang_getCString(usr);
+    std::string value = cStr ? cStr : "";
+    clang_disposeString(usr);
+    std::string anonymous = "@SA@" + name;
+    return value.size() < anonymous.size() ||
+           value.compare(value.size() - anonymous.size(), anonymous.size(), anonymous) != 0;
+}
+
+// C puts a struct declared inside another one at file scope, so the lexical parent is the one
+// that matters to C++, where the inner struct is a member of the outer
+std::string HeaderExtractor::getParentRecord(CXCursor cursor) {
+    CXCursor parent = clang_getCursorLexicalParent(cursor);
+    switch (clang_getCursorKind(parent)) {
+        case CXCursor_StructDecl:
+        case CXCursor_UnionDecl:
+        case CXCursor_ClassDecl:
+            return getCursorSpelling(parent);
+        default:
+            return "";
+    }
+}
+
+std::string HeaderExtractor::getComment(CXCursor cursor) {
+    CXString comment = clang_Cursor_getBriefCommentText(cursor);
+    const char* cStr = clang_getCString(comment);
+    std::string result = cStr ? cStr : ""; // Ensure we return an empty string if null
+    clang_disposeString(comment);
+    return result;
+}
+
+std::string HeaderExtractor::getStorageClass(CXCursor cursor) {
+    CX_StorageClass storageClass = clang_Cursor_getStorageClass(cursor);
+    switch (storageClass) {
+        case CX_SC_None: return "";
+        case CX_SC_Extern: return "extern";
+        case CX_SC_Static: return "static";
+        case CX_SC_PrivateExtern: return "private extern";
+        case CX_SC_Auto: return "auto";
+        case CX_SC_Register: return "register";
+        default: return "unknown";
+    }
+}
+
+std::string HeaderExtractor::getTypeQualifiers(CXType type) {
+    std::string qualifiers;
+
+    if (clang_isConstQualifiedType(type)) qualifiers += "const ";
+    if (clang_isVolatileQualifiedType(type)) qualifiers += "volatile ";
+
+    return qualifiers;
+}
+
+std::vector<int> HeaderExtractor::getArrayDimensions(CXType type) {
+    std::vector<int> dimensions;
+
+    while (clang_getArraySize(type) != -1) {
+        dimensions.push_back(clang_getArraySize(type));
+        type = clang_getArrayElementType(type);
+    }
+
+    return dimensions;
+}
+
+std::string HeaderExtractor::evaluateVariable(CXCursor cursor) {
+    CXEvalResult evalResult = clang_Cursor_Evaluate(cursor);
+    CXEvalResultKind kind = clang_EvalResult_getKind(evalResult);
+    std::string value;
+
+    switch (kind) {
+        case CXEval_Int:
+            value = std::to_string(clang_EvalResult_getAsInt(evalResult));
+            break;
+        case CXEval_Float:
+            value = std::to_string(clang_EvalResult_getAsDouble(evalResult));
+            break;
+        case CXEval_ObjCStrLiteral:
+        case CXEval_StrLiteral:
+        case CXEval_CFStr:
+            value = clang_EvalResult_getAsStr(evalResult);
+            break;
+        default:
+            value = "Unable to evaluate";
+    }
+
+    clang_EvalResult_dispose(evalResult);
+    return value;
+}
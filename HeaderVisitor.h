@@ -0,0 +1,517 @@
+#pragma once
+
+#include <clang-c/Index.h>
+#include "DeclarationFilter.h"
+#include "HeaderAnalyzer.h"
+#include "TraceRecorder.h"
+#include "TypeSpellingCache.h"
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * @class HeaderExtractor
+ * @brief Builds the declaration structures of HeaderAnalyzer from libclang cursors.
+ *
+ * The extract functions are templates on a combination of Field values: fields that are not
+ * selected are neither queried from libclang nor allocated, and keep their default value
+ * (empty, false, or -1 for layout). The name of a declaration is always extracted, and for a
+ * struct also whether it has a tag and the record it is nested in.
+ */
+class HeaderExtractor {
+public:
+    /**
+     * @enum Field
+     * @brief Groups of declaration fields, combined as a bitmask.
+     */
+    enum Field : unsigned {
+        Comments = 1u << 0,   /**< The brief comment of every declaration. */
+        Types = 1u << 1,      /**< Type spellings, variadic status and variable array dimensions. */
+        Members = 1u << 2,    /**< Enumerators, struct members (with bitfield widths) and function parameters. */
+        Layout = 1u << 3,     /**< Struct size and alignment, and member offset, size and canonical type. */
+        Values = 1u << 4,     /**< Evaluated variable values, which is the most expensive field. */
+        Qualifiers = 1u << 5, /**< Storage classes and const/volatile qualifiers. */
+        Attributes = 1u << 6, /**< The display names stored in FunctionInfo::attributes. */
+        AllFields = Comments | Types | Members | Layout | Values | Qualifiers | Attributes
+    };
+
+    template <unsigned Fields>
+    static HeaderAnalyzer::EnumInfo extractEnum(CXCursor cursor, TypeSpellingCache& types);
+    template <unsigned Fields>
+    static HeaderAnalyzer::StructInfo extractStruct(CXCursor cursor, TypeSpellingCache& types);
+    template <unsigned Fields>
+    static HeaderAnalyzer::FunctionInfo extractFunction(CXCursor cursor, TypeSpellingCache& types);
+    template <unsigned Fields>
+    static HeaderAnalyzer::VariableInfo extractVariable(CXCursor cursor, TypeSpellingCache& types);
+    template <unsigned Fields>
+    static HeaderAnalyzer::TypedefInfo extractTypedef(CXCursor cursor, TypeSpellingCache& types);
+
+    /**
+     * @brief Maps a cursor kind to the kind of declaration extracted from it.
+     * @param kind The cursor kind.
+     * @return The DeclarationFilter::Kind value, or 0 if nothing is extracted from such cursors.
+     */
+    static unsigned declarationKind(CXCursorKind kind);
+
+    /**
+     * @brief Parses a header the way HeaderAnalyzer does.
+     * @param index The index owning the translation unit.
+     * @param filename The path of the header.
+     * @param options The arguments and unsaved files to parse with; the filter is ignored.
+     * @param contents The contents of the header, or null to read it from disk.
+     * @return The translation unit, which the caller disposes.
+     * @throws std::runtime_error If the header cannot be parsed.
+     */
+    static CXTranslationUnit parse(CXIndex index, const std::string& filename, const HeaderAnalyzer::Options& options,
+                                   const std::string* contents);
+
+    /**
+     * @brief Sums the memory libclang reports for a translation unit.
+     * @param translationUnit The translation unit.
+     * @return The bytes held by its AST, source buffers and other allocations.
+     */
+    static size_t getTranslationUnitMemory(CXTranslationUnit translationUnit);
+
+    static std::string getCursorSpelling(CXCursor cursor);
+    static bool hasTag(CXCursor cursor, const std::string& name);
+    static std::string getParentRecord(CXCursor cursor);
+    static std::string getComment(CXCursor cursor);
+    static std::string getStorageClass(CXCursor cursor);
+    static std::string getTypeQualifiers(CXType type);
+    static std::vector<int> getArrayDimensions(CXType type);
+    static std::string evaluateVariable(CXCursor cursor);
+};
+
+/**
+ * @struct HeaderVisitorPolicy
+ * @brief Base of the policies of HeaderVisitor, handling every kind and field by default.
+ *
+ * A policy derives from this, hides kinds and fields with the ones it needs, and declares a
+ * handler for each selected kind:
+ *
+ * @code
+ * struct FunctionNames : HeaderVisitorPolicy {
+ *     static constexpr unsigned kinds = DeclarationFilter::Functions;
+ *     static constexpr unsigned fields = 0; // Names only
+ *     std::vector<std::string> names;
+ *     void onFunction(HeaderAnalyzer::FunctionInfo&& info) { names.push_back(std::move(info.name)); }
+ * };
+ * @endcode
+ *
+ * Handlers are onEnum, onStruct, onFunction, onVariable and onTypedef. Traversal passes them an
+ * rvalue, HeaderVisitor::visit a const lvalue. Handlers of kinds that are not selected are never
+ * called and need not exist. An exception thrown by a handler stops the traversal, and traverse
+ * rethrows it once libclang has returned.
+ */
+struct HeaderVisitorPolicy {
+    static constexpr unsigned kinds = DeclarationFilter::AllKinds; /**< The DeclarationFilter::Kind values handled. */
+    static constexpr unsigned fields = HeaderExtractor::AllFields; /**< The HeaderExtractor::Field values extracted. */
+
+    /**
+     * @brief Called by HeaderVisitor::visit before the declarations of one kind.
+     * @param kind The kind of the declarations that follow.
+     */
+    void beginSection(DeclarationFilter::Kind /*kind*/) {}
+
+    /**
+     * @brief Called by HeaderVisitor::visit after the declarations of one kind.
+     * @param kind The kind of the declarations that preceded.
+     */
+    void endSection(DeclarationFilter::Kind /*kind*/) {}
+};
+
+/**
+ * @class HeaderVisitor
+ * @brief Traverses a header and hands its declarations to a policy, resolved at compile time.
+ *
+ * Every handler call is bound statically, and the extraction of a kind the policy does not
+ * select is discarded with if constexpr, so a policy pays only for the kinds and fields it
+ * declares. HeaderAnalyzer itself is the instance for all kinds and fields, and writeToXML is
+ * the instance of visit() that formats every declaration.
+ *
+ * The traversal matches HeaderAnalyzer: each name is extracted once, except for typedefs, and
+ * declarations rejected by the filter are skipped before any extraction work.
+ *
+ * @tparam Policy The policy, usually derived from HeaderVisitorPolicy.
+ */
+template <typename Policy>
+class HeaderVisitor {
+public:
+    /**
+     * @brief Creates a visitor handing declarations to the given policy.
+     * @param policy The policy, which must outlive the visitor.
+     */
+    explicit HeaderVisitor(Policy& policy) : m_policy(policy) {}
+
+    /**
+     * @brief Parses a header and traverses it.
+     * @param filename The path of the header.
+     * @param options The options controlling how the header is parsed and filtered.
+     * @throws std::runtime_error If the header cannot be parsed.
+     * @throws Whatever a handler of the policy threw.
+     */
+    void traverse(const std::string& filename, const HeaderAnalyzer::Options& options) {
+        traverseHeader(filename, options, nullptr);
+    }
+
+    /**
+     * @brief Parses an in-memory header and traverses it.
+     * @param filename The name of the header, used to resolve relative includes.
+     * @param contents The contents of the header.
+     * @param options The options controlling how the header is parsed and filtered.
+     * @throws std::runtime_error If the header cannot be parsed.
+     */
+    void traverse(const std::string& filename, const std::string& contents, const HeaderAnalyzer::Options& options) {
+        traverseHeader(filename, options, &contents);
+    }
+
+    /**
+     * @brief Traverses a translation unit parsed by the caller.
+     * @param translationUnit The translation unit, which stays owned by the caller.
+     * @param filter Selects the declarations handed to the policy.
+     * @throws Whatever a handler of the policy threw.
+     */
+    void traverse(CXTranslationUnit translationUnit, const DeclarationFilter& filter = DeclarationFilter());
+
+    /**
+     * @brief Hands the declarations of an analyzer to the policy, without libclang.
+     *
+     * Kinds are visited in the order writeToXML writes them (enums, typedefs, structs,
+     * variables, functions), each between beginSection and endSection.
+     *
+     * @param analyzer The analyzer holding the declarations.
+     */
+    void visit(const HeaderAnalyzer& analyzer);
+
+    /**
+     * @brief Retrieves the type spelling statistics of all traversals so far.
+     * @return A constant reference to the statistics.
+     */
+    const TypeSpellingCache::Statistics& getTypeSpellingStatistics() const { return m_typeSpellings.getStatistics(); }
+
+    /**
+     * @brief Retrieves the memory of the last translation unit parsed by traverse, just before
+     *        it was disposed.
+     * @return The bytes libclang reported, 0 if no header was parsed.
+     */
+    size_t getTranslationUnitMemory() const { return m_translationUnitMemory; }
+
+private:
+    Policy& m_policy;
+
+    // Only populated during traversal
+    std::unordered_set<std::string> m_processedNames;
+    TypeSpellingCache m_typeSpellings;
+    const DeclarationFilter* m_filter = nullptr; // Only set when it rejects anything
+    size_t m_translationUnitMemory = 0;
+    std::exception_ptr m_error; // Thrown inside a libclang callback, rethrown once it returned
+
+    void traverseHeader(const std::string& filename, const HeaderAnalyzer::Options& options, const std::string* contents);
+
+    template <unsigned Kind, typename Info>
+    void visitSection(const std::vector<Info>& declarations);
+
+    static CXChildVisitResult visitNode(CXCursor cursor, CXCursor parent, CXClientData client_data);
+    static CXChildVisitResult visitCursor(CXCursor cursor, HeaderVisitor* visitor);
+};
+
+template <typename Policy>
+void HeaderVisitor<Policy>::traverseHeader(const std::string& filename, const HeaderAnalyzer::Options& options,
+                                           const std::string* contents) {
+    // Disposes the index and translation unit however parsing or traversal ends
+    struct Resources {
+        CXIndex index = clang_createIndex(0, 0);
+        CXTranslationUnit translationUnit = nullptr;
+        ~Resources() {
+            if (translationUnit) {
+                clang_disposeTranslationUnit(translationUnit);
+            }
+            clang_disposeIndex(index);
+        }
+    } resources;
+
+    resources.translationUnit = HeaderExtractor::parse(resources.index, filename, options, contents);
+    {
+        TraceRecorder::Span span("traverse", filename);
+        traverse(resources.translationUnit, options.filter);
+    }
+    m_translationUnitMemory = HeaderExtractor::getTranslationUnitMemory(resources.translationUnit);
+}
+
+template <typename Policy>
+void HeaderVisitor<Policy>::traverse(CXTranslationUnit translationUnit, const DeclarationFilter& filter) {
+    m_filter = filter.acceptsAll() ? nullptr : &filter;
+    clang_visitChildren(clang_getTranslationUnitCursor(translationUnit), &HeaderVisitor::visitNode, this);
+
+    // The processed-name set holds every cursor spelling seen, and the cached spellings are
+    // only valid for this translation unit
+    std::unordered_set<std::string>().swap(m_processedNames);
+    m_typeSpellings.clear();
+    m_filter = nullptr;
+
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+// Exceptions must not unwind through libclang, so they end the traversal here instead
+template <typename Policy>
+CXChildVisitResult HeaderVisitor<Policy>::visitNode(CXCursor cursor, CXCursor /*parent*/, CXClientData client_data) {
+    auto* visitor = static_cast<HeaderVisitor*>(client_data);
+    try {
+        return visitCursor(cursor, visitor);
+    } catch (...) {
+        visitor->m_error = std::current_exception();
+        return CXChildVisit_Break;
+    }
+}
+
+template <typename Policy>
+CXChildVisitResult HeaderVisitor<Policy>::visitCursor(CXCursor cursor, HeaderVisitor* visitor) {
+    CXCursorKind kind = clang_getCursorKind(cursor);
+    std::string name = HeaderExtractor::getCursorSpelling(cursor);
+
+    // Check if the name has already been processed
+    if (kind != CXCursor_TypedefDecl && visitor->m_processedNames.find(name) != visitor->m_processedNames.end()) {
+        return CXChildVisit_Recurse;
+    }
+
+    // Skip declarations rejected by the filter before doing any extraction work. The name is
+    // still marked as processed so that the remaining output does not depend on the filter.
+    if (visitor->m_filter) {
+        unsigned declarationKind = HeaderExtractor::declarationKind(kind);
+        if (declarationKind != 0 && !(visitor->m_filter->acceptsKind(static_cast<DeclarationFilter::Kind>(declarationKind)) &&
+                                      visitor->m_filter->acceptsName(name))) {
+            visitor->m_processedNames.insert(name);
+            return CXChildVisit_Recurse;
+        }
+    }
+
+    // Kinds the policy does not handle leave an empty case behind. Extraction is not traced per
+    // declaration, which would be an event per declaration; the traverse span covers it.
+    constexpr unsigned kinds = Policy::kinds;
+    constexpr unsigned fields = Policy::fields;
+    TypeSpellingCache& types = visitor->m_typeSpellings;
+    switch (kind) {
+        case CXCursor_EnumDecl:
+            if constexpr ((kinds & DeclarationFilter::Enums) != 0) {
+                visitor->m_policy.onEnum(HeaderExtractor::extractEnum<fields>(cursor, types));
+            }
+            break;
+        case CXCursor_StructDecl:
+            if constexpr ((kinds & DeclarationFilter::Structs) != 0) {
+                visitor->m_policy.onStruct(HeaderExtractor::extractStruct<fields>(cursor, types));
+            }
+            break;
+        case CXCursor_FunctionDecl:
+            if constexpr ((kinds & DeclarationFilter::Functions) != 0) {
+                visitor->m_policy.onFunction(HeaderExtractor::extractFunction<fields>(cursor, types));
+            }
+            break;
+        case CXCursor_VarDecl:
+            if constexpr ((kinds & DeclarationFilter::Variables) != 0) {
+                visitor->m_policy.onVariable(HeaderExtractor::extractVariable<fields>(cursor, types));
+            }
+            break;
+        case CXCursor_TypedefDecl:
+            if constexpr ((kinds & DeclarationFilter::Typedefs) != 0) {
+                visitor->m_policy.onTypedef(HeaderExtractor::extractTypedef<fields>(cursor, types));
+            }
+            break;
+        default:
+            break;
+    }
+
+    visitor->m_processedNames.insert(std::move(name));
+    return CXChildVisit_Recurse;
+}
+
+template <typename Policy>
+void HeaderVisitor<Policy>::visit(const HeaderAnalyzer& analyzer) {
+    visitSection<DeclarationFilter::Enums>(analyzer.getEnums());
+    visitSection<DeclarationFilter::Typedefs>(analyzer.getTypedefs());
+    visitSection<DeclarationFilter::Structs>(analyzer.getStructs());
+    visitSection<DeclarationFilter::Variables>(analyzer.getVariables());
+    visitSection<DeclarationFilter::Functions>(analyzer.getFunctions());
+}
+
+template <typename Policy>
+template <unsigned Kind, typename Info>
+void HeaderVisitor<Policy>::visitSection(const std::vector<Info>& declarations) {
+    if constexpr ((Policy::kinds & Kind) != 0) {
+        m_policy.beginSection(static_cast<DeclarationFilter::Kind>(Kind));
+        for (const Info& info : declarations) {
+            if constexpr (Kind == DeclarationFilter::Enums) {
+                m_policy.onEnum(info);
+            } else if constexpr (Kind == DeclarationFilter::Typedefs) {
+                m_policy.onTypedef(info);
+            } else if constexpr (Kind == DeclarationFilter::Structs) {
+                m_policy.onStruct(info);
+            } else if constexpr (Kind == DeclarationFilter::Variables) {
+                m_policy.onVariable(info);
+            } else {
+                m_policy.onFunction(info);
+            }
+        }
+        m_policy.endSection(static_cast<DeclarationFilter::Kind>(Kind));
+    }
+}
+
+template <unsigned Fields>
+HeaderAnalyzer::EnumInfo HeaderExtractor::extractEnum(CXCursor cursor, TypeSpellingCache& types) {
+    HeaderAnalyzer::EnumInfo info;
+    info.name = getCursorSpelling(cursor);
+    if constexpr ((Fields & Comments) != 0) {
+        info.comment = getComment(cursor);
+    }
+
+    if constexpr ((Fields & Members) != 0) {
+        clang_visitChildren(
+            cursor,
+            [](CXCursor c, CXCursor /*parent*/, CXClientData client_data) {
+                auto* info = static_cast<HeaderAnalyzer::EnumInfo*>(client_data);
+                if (clang_getCursorKind(c) == CXCursor_EnumConstantDecl) {
+                    info->enumerators.emplace_back(getCursorSpelling(c), clang_getEnumConstantDeclValue(c));
+                }
+                return CXChildVisit_Continue;
+            },
+            &info
+        );
+    }
+
+    if constexpr ((Fields & Types) != 0) {
+        info.underlyingType = types.getSpelling(clang_getEnumDeclIntegerType(cursor));
+    }
+    return info;
+}
+
+template <unsigned Fields>
+HeaderAnalyzer::StructInfo HeaderExtractor::extractStruct(CXCursor cursor, TypeSpellingCache& types) {
+    HeaderAnalyzer::StructInfo info;
+    info.name = getCursorSpelling(cursor);
+    info.tagged = hasTag(cursor, info.name);
+    info.parent = getParentRecord(cursor);
+    if constexpr ((Fields & Comments) != 0) {
+        info.comment = getComment(cursor);
+    }
+
+    // Layout queries return negative error codes for incomplete or dependent types
+    info.size = -1;
+    info.alignment = -1;
+    if constexpr ((Fields & Layout) != 0) {
+        CXType type = clang_getCursorType(cursor);
+        info.size = std::max(clang_Type_getSizeOf(type), -1LL);
+        info.alignment = std::max(clang_Type_getAlignOf(type), -1LL);
+    }
+
+    if constexpr ((Fields & Members) != 0) {
+        struct MemberVisitorData {
+            HeaderAnalyzer::StructInfo* info;
+            TypeSpellingCache* types;
+        } data = {&info, &types};
+
+        clang_visitChildren(
+            cursor,
+            [](CXCursor c, CXCursor /*parent*/, CXClientData client_data) {
+                auto* data = static_cast<MemberVisitorData*>(client_data);
+                if (clang_getCursorKind(c) == CXCursor_FieldDecl) {
+                    HeaderAnalyzer::StructMember member;
+                    member.name = getCursorSpelling(c);
+                    member.bitfieldWidth = clang_getFieldDeclBitWidth(c);
+                    member.offset = -1;
+                    member.size = -1;
+                    CXType memberType = clang_getCursorType(c);
+                    if constexpr ((Fields & Types) != 0) {
+                        member.type = data->types->getSpelling(memberType);
+                    }
+                    if constexpr ((Fields & Layout) != 0) {
+                        member.offset = std::max(clang_Cursor_getOffsetOfField(c), -1LL);
+                        member.size = std::max(clang_Type_getSizeOf(memberType), -1LL);
+                        member.canonicalType = data->types->getSpelling(clang_getCanonicalType(memberType));
+                    }
+                    data->info->members.push_back(std::move(member));
+                }
+                return CXChildVisit_Continue;
+            },
+            &data
+        );
+    }
+    return info;
+}
+
+template <unsigned Fields>
+HeaderAnalyzer::FunctionInfo HeaderExtractor::extractFunction(CXCursor cursor, TypeSpellingCache& types) {
+    HeaderAnalyzer::FunctionInfo info;
+    info.name = getCursorSpelling(cursor);
+    info.isVariadic = false;
+    if constexpr ((Fields & Types) != 0) {
+        info.returnType = types.getSpelling(clang_getCursorResultType(cursor));
+        info.isVariadic = clang_isFunctionTypeVariadic(clang_getCursorType(cursor));
+    }
+    if constexpr ((Fields & Comments) != 0) {
+        info.comment = getComment(cursor);
+    }
+
+    if constexpr ((Fields & Members) != 0) {
+        int numArgs = clang_Cursor_getNumArguments(cursor);
+        for (int i = 0; i < numArgs; ++i) {
+            CXCursor arg = clang_Cursor_getArgument(cursor, i);
+            std::string argType;
+            if constexpr ((Fields & Types) != 0) {
+                argType = types.getSpelling(clang_getCursorType(arg));
+            }
+            info.parameters.emplace_back(getCursorSpelling(arg), std::move(argType));
+        }
+    }
+
+    if constexpr ((Fields & Attributes) != 0) {
+        CXString attrSpelling = clang_getCursorDisplayName(cursor);
+        const char* cStr = clang_getCString(attrSpelling);
+        info.attributes = cStr ? cStr : ""; // Ensure we return an empty string if null
+        clang_disposeString(attrSpelling);
+    }
+    return info;
+}
+
+template <unsigned Fields>
+HeaderAnalyzer::VariableInfo HeaderExtractor::extractVariable(CXCursor cursor, TypeSpellingCache& types) {
+    HeaderAnalyzer::VariableInfo info;
+    info.name = getCursorSpelling(cursor);
+    if constexpr ((Fields & Types) != 0) {
+        CXType type = clang_getCursorType(cursor);
+        info.type = types.getSpelling(type);
+        info.arrayDimensions = getArrayDimensions(type);
+    }
+    if constexpr ((Fields & Comments) != 0) {
+        info.comment = getComment(cursor);
+    }
+    if constexpr ((Fields & Qualifiers) != 0) {
+        info.storageClass = getStorageClass(cursor);
+        info.qualifiers = getTypeQualifiers(clang_getCursorType(cursor));
+    }
+    if constexpr ((Fields & Values) != 0) {
+        info.value = evaluateVariable(cursor);
+    }
+    return info;
+}
+
+template <unsigned Fields>
+HeaderAnalyzer::TypedefInfo HeaderExtractor::extractTypedef(CXCursor cursor, TypeSpellingCache& types) {
+    HeaderAnalyzer::TypedefInfo info;
+    info.newName = getCursorSpelling(cursor);
+    if constexpr ((Fields & Types) != 0) {
+        info.originalType = types.getSpelling(clang_getCursorType(cursor));
+    }
+    if constexpr ((Fields & Comments) != 0) {
+        info.comment = getComment(cursor);
+    }
+    if constexpr ((Fields & Qualifiers) != 0) {
+        info.qualifiers = getTypeQualifiers(clang_getCursorType(cursor));
+    }
+    return info;
+}
@@ -0,0 +1,282 @@
+#include "IncludeProfiler.h"
+#include "BoundedExecutor.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+const size_t kNoParent = static_cast<size_t>(-1);
+
+// Shared by the inclusion and declaration visitors of one translation unit
+struct ProfileData {
+    CXTranslationUnit translationUnit;
+    IncludeProfiler::Profile* profile;
+    std::unordered_map<CXFile, size_t> indices; // Index of each file in profile->files
+};
+
+std::string getFileName(CXFile file) {
+    CXString name = clang_getFileName(file);
+    const char* cStr = clang_getCString(name);
+    std::string result = cStr ? cStr : "";
+    clang_disposeString(name);
+    return result;
+}
+
+void visitInclusion(CXFile file, CXSourceLocation* stack, unsigned stackSize, CXClientData client_data) {
+    auto* data = static_cast<ProfileData*>(client_data);
+    std::vector<IncludeProfiler::FileCost>& files = data->profile->files;
+
+    // A file without an include guard is visited once per include; only the first one costs anything
+    if (file == nullptr || data->indices.count(file) != 0) {
+        return;
+    }
+
+    IncludeProfiler::FileCost cost{};
+    cost.parent = kNoParent;
+    if (stackSize > 0) {
+        if (files.empty()) {
+            return; // Not reachable from the header
+        }
+        // The top of the stack is the #include directive in the including file
+        CXFile includer = nullptr;
+        clang_getExpansionLocation(stack[0], &includer, nullptr, nullptr, nullptr);
+        auto it = data->indices.find(includer);
+        cost.parent = it != data->indices.end() ? it->second : 0;
+        cost.depth = files[cost.parent].depth + 1;
+    } else if (!files.empty()) {
+        return; // Only the header itself has an empty stack
+    }
+
+    cost.filename = getFileName(file);
+    size_t size = 0;
+    cost.bytes = clang_getFileContents(data->translationUnit, file, &size) ? static_cast<long long>(size) : 0;
+    data->indices.emplace(file, files.size());
+    files.push_back(cost);
+}
+
+CXChildVisitResult countDeclaration(CXCursor cursor, CXCursor /*parent*/, CXClientData client_data) {
+    auto* data = static_cast<ProfileData*>(client_data);
+    CXCursorKind kind = clang_getCursorKind(cursor);
+    if (kind == CXCursor_Namespace || kind == CXCursor_LinkageSpec) {
+        return CXChildVisit_Recurse;
+    }
+    if (clang_isDeclaration(kind)) {
+        // Declarations produced by a macro count for the file that expands it
+        CXFile file = nullptr;
+        clang_getExpansionLocation(clang_getCursorLocation(cursor), &file, nullptr, nullptr, nullptr);
+        auto it = data->indices.find(file);
+        if (it != data->indices.end()) {
+            ++data->profile->files[it->second].declarations;
+        }
+    }
+    return CXChildVisit_Continue;
+}
+
+// Semicolons separate the frames of a folded stack
+std::string frameName(const std::string& filename) {
+    std::string result = filename;
+    std::replace(result.begin(), result.end(), ';', ':');
+    return result;
+}
+
+} // namespace
+
+IncludeProfiler::IncludeProfiler(const std::vector<std::string>& headers)
+    : IncludeProfiler(headers, HeaderAnalyzer::Options()) {
+}
+
+IncludeProfiler::IncludeProfiler(const std::vector<std::string>& headers, const HeaderAnalyzer::Options& options) {
+    // Start every header first so that they are parsed concurrently
+    std::vector<std::future<Profile>> futures;
+    futures.reserve(headers.size());
+    for (const auto& header : headers) {
+        auto promise = std::make_shared<std::promise<Profile>>();
+        futures.push_back(promise->get_future());
+        BoundedExecutor::shared().submit([header, &options, promise]() {
+            try {
+                promise->set_value(profileHeader(header, options));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+    }
+
+    m_profiles.reserve(futures.size());
+    for (auto& future : futures) {
+        m_profiles.push_back(future.get());
+    }
+}
+
+size_t IncludeProfiler::getFailureCount() const {
+    return static_cast<size_t>(std::count_if(m_profiles.begin(), m_profiles.end(),
+                                             [](const Profile& profile) { return !profile.error.empty(); }));
+}
+
+IncludeProfiler::Profile IncludeProfiler::profileHeader(const std::string& header, const HeaderAnalyzer::Options& options) {
+    Profile profile;
+    profile.header = header;
+
+    std::vector<const char*> arguments;
+    arguments.reserve(options.arguments.size());
+    for (const auto& argument : options.arguments) {
+        arguments.push_back(argument.c_str());
+    }
+    std::vector<CXUnsavedFile> unsavedFiles;
+    unsavedFiles.reserve(options.unsavedFiles.size());
+    for (const auto& file : options.unsavedFiles) {
+        unsavedFiles.push_back({file.filename.c_str(), file.contents.data(), static_cast<unsigned long>(file.contents.size())});
+    }
+
+    CXIndex index = clang_createIndex(0, 0);
+    CXTranslationUnit translationUnit;
+    {
+        TraceRecorder::Span span("parse", header);
+        translationUnit = clang_parseTranslationUnit(
+            index,
+            header.c_str(), arguments.data(), static_cast<int>(arguments.size()),
+            unsavedFiles.data(), static_cast<unsigned>(unsavedFiles.size()),
+            CXTranslationUnit_None);
+    }
+
+    if (translationUnit == nullptr) {
+        clang_disposeIndex(index);
+        profile.error = "Unable to parse translation unit.";
+        return profile;
+    }
+
+    {
+        TraceRecorder::Span span("profile-includes", header);
+        ProfileData data = {translationUnit, &profile, {}};
+        clang_getInclusions(translationUnit, &visitInclusion, &data);
+        clang_visitChildren(clang_getTranslationUnitCursor(translationUnit), &countDeclaration, &data);
+    }
+
+    clang_disposeTranslationUnit(translationUnit);
+    clang_disposeIndex(index);
+    if (profile.files.empty()) {
+        profile.error = "No include information.";
+        return profile;
+    }
+    computeTransitiveCosts(profile);
+    return profile;
+}
+
+void IncludeProfiler::computeTransitiveCosts(Profile& profile) {
+    std::vector<FileCost>& files = profile.files;
+    for (auto& file : files) {
+        file.transitiveBytes = file.bytes;
+        file.transitiveDeclarations = file.declarations;
+        file.transitiveFiles = 1;
+    }
+    // Files come after the file that includes them, so a reverse pass visits children first
+    for (size_t i = files.size(); i-- > 1;) {
+        FileCost& parent = files[files[i].parent];
+        parent.transitiveBytes += files[i].transitiveBytes;
+        parent.transitiveDeclarations += files[i].transitiveDeclarations;
+        parent.transitiveFiles += files[i].transitiveFiles;
+    }
+}
+
+void IncludeProfiler::writeReport(const std::string& outputFilename) const {
+    CompressedFileWriter outFile(outputFilename, Compression::None);
+    if (!outFile.isOpen()) {
+        std::cerr << outFile.getError() << std::endl;
+        return;
+    }
+
+    struct Total {
+        long long bytes = 0;
+        size_t declarations = 0;
+        size_t headers = 0;
+    };
+    std::unordered_map<std::string, Total> totals;
+    size_t profiled = 0;
+
+    std::ostringstream report;
+    for (const auto& profile : m_profiles) {
+        if (!profile.error.empty()) {
+            report << profile.header << ": error: " << profile.error << "\n\n";
+            continue;
+        }
+        ++profiled;
+
+        const FileCost& root = profile.files[0];
+        size_t maxDepth = 0;
+        for (const auto& file : profile.files) {
+            maxDepth = std::max(maxDepth, file.depth);
+        }
+        report << profile.header << ": " << root.transitiveFiles << " files, " << root.transitiveBytes << " bytes, "
+               << root.transitiveDeclarations << " declarations, include depth " << maxDepth << "\n\n";
+        report << "   total bytes  total decls   files     own bytes  own decls  file\n";
+        for (const auto& file : profile.files) {
+            report << std::setw(14) << file.transitiveBytes << std::setw(13) << file.transitiveDeclarations
+                   << std::setw(8) << file.transitiveFiles << std::setw(14) << file.bytes
+                   << std::setw(11) << file.declarations << "  " << std::string(2 * file.depth, ' ')
+                   << file.filename << "\n";
+        }
+        report << "\n";
+
+        for (size_t i = 1; i < profile.files.size(); ++i) {
+            Total& total = totals[profile.files[i].filename];
+            total.bytes += profile.files[i].transitiveBytes;
+            total.declarations += profile.files[i].transitiveDeclarations;
+            ++total.headers;
+        }
+    }
+
+    // Rank includes by what they cost over the whole project
+    std::vector<std::pair<std::string, Total>> ranked(totals.begin(), totals.end());
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.second.bytes != b.second.bytes ? a.second.bytes > b.second.bytes : a.first < b.first;
+    });
+    report << "Includes by bytes pulled in, summed over " << profiled << " headers\n\n";
+    report << "   total bytes  total decls  headers  file\n";
+    for (const auto& entry : ranked) {
+        report << std::setw(14) << entry.second.bytes << std::setw(13) << entry.second.declarations
+               << std::setw(9) << entry.second.headers << "  " << entry.first << "\n";
+    }
+
+    outFile.write(report.str());
+
+    if (!outFile.close()) {
+        std::cerr << outFile.getError() << std::endl;
+    }
+}
+
+void IncludeProfiler::writeFoldedStacks(const std::string& outputFilename, Metric metric) const {
+    CompressedFileWriter outFile(outputFilename, Compression::None);
+    if (!outFile.isOpen()) {
+        std::cerr << outFile.getError() << std::endl;
+        return;
+    }
+
+    // Sorted, so that equal stacks of different headers are merged and the output is stable
+    std::map<std::string, long long> stacks;
+    for (const auto& profile : m_profiles) {
+        std::vector<std::string> paths(profile.files.size());
+        for (size_t i = 0; i < profile.files.size(); ++i) {
+            const FileCost& file = profile.files[i];
+            paths[i] = (i == 0 ? "" : paths[file.parent] + ";") + frameName(file.filename);
+            long long value = metric == Metric::Bytes ? file.bytes : static_cast<long long>(file.declarations);
+            if (value > 0) {
+                stacks[paths[i]] += value;
+            }
+        }
+    }
+
+    std::string out;
+    for (const auto& stack : stacks) {
+        out += stack.first + " " + std::to_string(stack.second) + "\n";
+    }
+    outFile.write(out);
+
+    if (!outFile.close()) {
+        std::cerr << outFile.getError() << std::endl;
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "HeaderAnalyzer.h"
+#include <string>
+#include <vector>
+
+/**
+ * @class IncludeProfiler
+ * @brief Measures which includes make parsing a header expensive.
+ *
+ * Each header is parsed with the same options HeaderAnalyzer uses. The include tree comes from
+ * clang_getInclusions, where every file is attributed to the file that included it first; a
+ * later include of the same file costs nothing because of its include guard. Every file in the
+ * tree is measured by its own size in bytes and the number of declarations it contributes, and
+ * those costs are summed up the tree, so the transitive cost of an include is what removing it
+ * would save.
+ *
+ * Declarations are counted at namespace scope, including those inside namespaces and
+ * extern "C" blocks, and are attributed to the file they are expanded in.
+ */
+class IncludeProfiler {
+public:
+    /**
+     * @struct FileCost
+     * @brief The cost of one file in the include tree of a header.
+     */
+    struct FileCost {
+        std::string filename; /**< The path of the file, as clang resolved it. */
+        size_t parent; /**< The index of the file that included this one first, or size_t(-1) for the header itself. */
+        size_t depth; /**< The number of includes between the header and this file, 0 for the header itself. */
+        long long bytes; /**< The size of the file in bytes. */
+        size_t declarations; /**< The number of declarations in the file. */
+        long long transitiveBytes; /**< The bytes of the file and everything it pulls in first. */
+        size_t transitiveDeclarations; /**< The declarations of the file and everything it pulls in first. */
+        size_t transitiveFiles; /**< The number of files in this subtree, including the file itself. */
+    };
+
+    /**
+     * @struct Profile
+     * @brief The include tree of one header.
+     */
+    struct Profile {
+        std::string header; /**< The profiled header. */
+        std::vector<FileCost> files; /**< The include tree in include order; files[0] is the header. */
+        std::string error; /**< Why the header could not be parsed, empty on success. */
+    };
+
+    /**
+     * @brief Selects the cost a flame graph is weighted by.
+     */
+    enum class Metric {
+        Bytes,       /**< Source bytes, which approximate preprocessing and parsing work. */
+        Declarations /**< Declarations, which approximate semantic analysis work. */
+    };
+
+    /**
+     * @brief Profiles the include trees of the given headers.
+     * @param headers The paths of the headers to profile.
+     */
+    IncludeProfiler(const std::vector<std::string>& headers);
+
+    /**
+     * @brief Profiles the include trees of the given headers using the given options.
+     *
+     * Headers are parsed concurrently on the shared executor. A header that fails to parse is
+     * reported through Profile::error instead of an exception.
+     *
+     * @param headers The paths of the headers to profile.
+     * @param options The options controlling how the headers are parsed; the filter is ignored.
+     */
+    IncludeProfiler(const std::vector<std::string>& headers, const HeaderAnalyzer::Options& options);
+
+    /**
+     * @brief Retrieves the profiles, one per header in the order given to the constructor.
+     * @return A constant reference to the vector of profiles.
+     */
+    const std::vector<Profile>& getProfiles() const { return m_profiles; }
+
+    /**
+     * @brief Retrieves the number of headers that could not be parsed.
+     * @return The number of profiles with an error.
+     */
+    size_t getFailureCount() const;
+
+    /**
+     * @brief Writes a text report.
+     *
+     * The report shows the include tree of every header with its own and transitive costs,
+     * followed by every included file ranked by the bytes it pulls in, summed over all headers.
+     *
+     * @param outputFilename The name of the output text file.
+     */
+    void writeReport(const std::string& outputFilename) const;
+
+    /**
+     * @brief Writes the include trees in the folded stack format of flamegraph.pl and speedscope.
+     *
+     * Each line is an include stack ("a.h;b.h;c.h") followed by the own cost of its last file.
+     * Identical stacks of different headers are merged.
+     *
+     * @param outputFilename The name of the output file.
+     * @param metric The cost the stacks are weighted by.
+     */
+    void writeFoldedStacks(const std::string& outputFilename, Metric metric = Metric::Bytes) const;
+
+private:
+    std::vector<Profile> m_profiles;
+
+    static Profile profileHeader(const std::string& header, const HeaderAnalyzer::Options& options);
+    static void computeTransitiveCosts(Profile& profile);
+};
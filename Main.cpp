@@ -1,24 +1,377 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <vector>
 #include "HeaderAnalyzer.h" // Make sure to include the header file where HeaderAnalyzer class is defined
+#include "EnumTableGenerator.h"
+#include "HeaderDiff.h"
+#include "IncludeProfiler.h"
+#include "MultiConfigAnalyzer.h"
+#include "ProcessPool.h"
+#include "SQLiteExporter.h"
+#include "StructSerializerGenerator.h"
+#include "TraceRecorder.h"
+
+// Options parsed from the command line
+struct CommandLine {
+    bool diffMode = false;
+    bool batchMode = false;
+    bool profileMode = false;
+    bool sqliteMode = false; // Write to a SQLite database instead of XML
+    bool printStats = false;
+    Compression compression = Compression::Auto;
+    std::vector<MultiConfigAnalyzer::Configuration> configurations;
+    size_t processes = 0;
+    long timeoutMs = 0;
+    size_t serializeThreads = 0; // 0 for one per hardware thread
+    std::string traceFile;
+    std::string flameGraphFile;
+    std::string enumTablesNamespace; // Non-empty to write enum lookup tables instead of XML
+    std::string serializersNamespace; // Non-empty to write struct serializers instead of XML
+    HeaderAnalyzer::Options analyzer;
+    std::vector<std::string> positional;
+};
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] <input_header_file> <output_xml_file>" << std::endl;
+    std::cerr << "       " << program << " [options] --batch <input_header_file>... <output_directory>" << std::endl;
+    std::cerr << "       " << program << " [options] --sqlite [--batch] <input_header_file>... <database_file>" << std::endl;
+    std::cerr << "       " << program << " [options] --include-profile <input_header_file>... <report_file>" << std::endl;
+    std::cerr << "       " << program << " [options] --diff <old_header_or_xml> <new_header_or_xml> <output_xml_file>" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --stats                   Print type spelling and memory statistics" << std::endl;
+    std::cerr << "  --compress=<format>       gzip, zstd or none (default: from the output extension)" << std::endl;
+    std::cerr << "  --serialize-threads=<count>" << std::endl;
+    std::cerr << "                            Format the XML on this many threads (default: one per core, 1: sequential)" << std::endl;
+    std::cerr << "  --processes=<count>       In batch mode, analyze in this many crash-isolated worker processes" << std::endl;
+    std::cerr << "  --timeout=<ms>            With --processes, kill a worker that spends longer on one header" << std::endl;
+    std::cerr << "  --enum-tables[=<namespace>]" << std::endl;
+    std::cerr << "                            Write a C++ header with enum lookup tables instead of XML" << std::endl;
+    std::cerr << "  --struct-serializers[=<namespace>]" << std::endl;
+    std::cerr << "                            Write a C++ header with packed binary struct serializers instead of XML" << std::endl;
+    std::cerr << "  --flamegraph=<file>       With --include-profile, also write folded include stacks for a flame graph" << std::endl;
+    std::cerr << "  --trace=<file.json>       Write a Chrome trace_event timeline of the run" << std::endl;
+    std::cerr << "  --kinds=<kind>[,<kind>...]" << std::endl;
+    std::cerr << "                            Only extract these kinds: enum, struct, function, variable, typedef" << std::endl;
+    std::cerr << "  --include-prefix=<prefix> Only extract declarations whose name starts with a given prefix" << std::endl;
+    std::cerr << "  --exclude-prefix=<prefix> Skip declarations whose name starts with this prefix" << std::endl;
+    std::cerr << "  --include-regex=<regex>   Only extract declarations whose name matches a given regex" << std::endl;
+    std::cerr << "  --exclude-regex=<regex>   Skip declarations whose name matches this regex" << std::endl;
+    std::cerr << "  --config=<name>,<triple>[,<define>...]" << std::endl;
+    std::cerr << "                            Analyze under this configuration; repeat to analyze several" << std::endl;
+    std::cerr << "                            configurations at once (an empty triple means the host)" << std::endl;
+}
+
+// Parses "<name>,<triple>[,<define>...]"
+static MultiConfigAnalyzer::Configuration parseConfiguration(const std::string& value) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (;;) {
+        size_t comma = value.find(',', start);
+        fields.push_back(value.substr(start, comma - start));
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    MultiConfigAnalyzer::Configuration configuration;
+    configuration.name = fields[0];
+    configuration.targetTriple = fields.size() > 1 ? fields[1] : "";
+    configuration.defines.assign(fields.begin() + std::min<size_t>(fields.size(), 2), fields.end());
+    return configuration;
+}
+
+static bool parseCompression(const std::string& value, Compression& compression) {
+    if (value == "gzip") compression = Compression::Gzip;
+    else if (value == "zstd") compression = Compression::Zstd;
+    else if (value == "none") compression = Compression::None;
+    else return false;
+    return true;
+}
+
+// Parses "function,struct" into a DeclarationFilter::Kind mask
+static bool parseKinds(const std::string& value, unsigned& kinds) {
+    kinds = 0;
+    size_t start = 0;
+    for (;;) {
+        size_t comma = value.find(',', start);
+        std::string kind = value.substr(start, comma - start);
+        if (kind == "enum") kinds |= DeclarationFilter::Enums;
+        else if (kind == "struct") kinds |= DeclarationFilter::Structs;
+        else if (kind == "function") kinds |= DeclarationFilter::Functions;
+        else if (kind == "variable") kinds |= DeclarationFilter::Variables;
+        else if (kind == "typedef") kinds |= DeclarationFilter::Typedefs;
+        else return false;
+        if (comma == std::string::npos) return true;
+        start = comma + 1;
+    }
+}
+
+static bool addPattern(DeclarationFilter& filter, const std::string& pattern, bool include) {
+    try {
+        if (include) {
+            filter.addIncludePattern(pattern);
+        } else {
+            filter.addExcludePattern(pattern);
+        }
+    } catch (const std::regex_error& e) {
+        std::cerr << "Invalid regex: " << pattern << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool parseCount(const std::string& value, long& count) {
+    char* end = nullptr;
+    count = std::strtol(value.c_str(), &end, 10);
+    return !value.empty() && *end == '\0' && count >= 0;
+}
+
+// Diff inputs may be headers or XML files written by an earlier run
+static HeaderAnalyzer loadOrAnalyze(const std::string& filename, const HeaderAnalyzer::Options& options) {
+    for (const char* suffix : {".xml", ".xml.gz", ".xml.zst"}) {
+        std::string extension = suffix;
+        if (filename.size() >= extension.size() &&
+            filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0) {
+            return HeaderAnalyzer::loadFromXML(filename);
+        }
+    }
+    return HeaderAnalyzer(filename, options);
+}
+
+// Output path of a header in batch mode, e.g. "out/foo.xml.gz" for "include/foo.h"
+static std::string batchOutputPath(const std::string& header, const std::string& directory, Compression compression) {
+    size_t slash = header.find_last_of('/');
+    std::string stem = slash == std::string::npos ? header : header.substr(slash + 1);
+    size_t dot = stem.find_last_of('.');
+    if (dot != std::string::npos && dot != 0) {
+        stem.resize(dot);
+    }
+    std::string extension = compression == Compression::Gzip ? ".xml.gz"
+                          : compression == Compression::Zstd ? ".xml.zst"
+                          : ".xml";
+    return directory + "/" + stem + extension;
+}
+
+// Receives each analyzed header in batch mode, possibly on several threads at once
+using BatchOutput = std::function<void(const HeaderAnalyzer& analyzer)>;
+
+// Reports an error of one header, whatever was thrown; the batch continues with the others
+static void reportBatchError(const std::string& header, std::exception_ptr error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << header << ": " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Error: " << header << ": Unknown error." << std::endl;
+    }
+}
+
+// Analyzes and outputs every header on the shared executor, so each worker runs whole
+// headers end to end. Returns the number of headers that failed.
+static int runBatch(const std::vector<std::string>& headers, const BatchOutput& output,
+                    const HeaderAnalyzer::Options& options) {
+    std::atomic<int> failures{0};
+    std::vector<std::future<void>> done;
+    done.reserve(headers.size());
+    for (const auto& header : headers) {
+        auto finished = std::make_shared<std::promise<void>>();
+        done.push_back(finished->get_future());
+        HeaderAnalyzer::analyzeAsync(header, options,
+            [header, &output, finished, &failures](std::unique_ptr<HeaderAnalyzer> analyzer, std::exception_ptr error) {
+                if (!error) {
+                    try {
+                        output(*analyzer);
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                }
+                if (error) {
+                    reportBatchError(header, error);
+                    ++failures;
+                }
+                finished->set_value();
+            });
+    }
+    for (auto& future : done) {
+        future.wait();
+    }
+    return failures;
+}
+
+// Same as runBatch, but each header is analyzed in a worker process, so a header that crashes
+// or hangs libclang is reported as failed instead of taking down the run.
+static int runProcessBatch(const std::vector<std::string>& headers, const BatchOutput& output,
+                           const HeaderAnalyzer::Options& options, size_t processes, std::chrono::milliseconds timeout) {
+    int failures = 0;
+    ProcessPool pool(processes, timeout, options);
+    pool.analyze(headers, [&](ProcessPool::Result result) {
+        if (!result.analyzer) {
+            std::cerr << "Error: " << result.filename << ": " << result.error << std::endl;
+            ++failures;
+            return;
+        }
+        try {
+            output(*result.analyzer);
+        } catch (...) {
+            reportBatchError(result.filename, std::current_exception());
+            ++failures;
+        }
+    });
+    return failures;
+}
+
+static void printStatistics(const std::string& inputHeaderFile, const HeaderAnalyzer& analyzer) {
+    const auto& stats = analyzer.getTypeSpellingStatistics();
+    std::cerr << inputHeaderFile << ": " << stats.lookups << " type spellings requested, "
+              << stats.spellingCalls << " clang_getTypeSpelling calls" << std::endl;
+    if (analyzer.getTranslationUnitMemory() != 0) {
+        std::cerr << inputHeaderFile << ": " << analyzer.getTranslationUnitMemory()
+                  << " bytes of translation unit memory released after extraction" << std::endl;
+    }
+}
+
+static int run(const CommandLine& options, const char* program) {
+    const std::vector<std::string>& positional = options.positional;
+    Compression compression = options.compression;
+
+    // Batch mode analyzes many headers concurrently, in threads or in worker processes
+    if (options.batchMode) {
+        if (positional.size() < 2) {
+            printUsage(program);
+            return 1;
+        }
+        std::vector<std::string> headers(positional.begin(), positional.end() - 1);
+        const std::string& destination = positional.back();
+        try {
+            // Headers are analyzed concurrently, but a database connection takes one at a time
+            std::unique_ptr<SQLiteExporter> database;
+            std::mutex databaseMutex;
+            BatchOutput output;
+            if (options.sqliteMode) {
+                database.reset(new SQLiteExporter(destination));
+                output = [&database, &databaseMutex](const HeaderAnalyzer& analyzer) {
+                    std::lock_guard<std::mutex> lock(databaseMutex);
+                    database->add(analyzer);
+                };
+            } else {
+                // Throwing counts the header as failed
+                output = [&destination, compression](const HeaderAnalyzer& analyzer) {
+                    std::string path = batchOutputPath(analyzer.getFilename(), destination, compression);
+                    if (!analyzer.writeToXML(path, compression)) {
+                        throw std::runtime_error("Unable to write " + path);
+                    }
+                };
+            }
+
+            int failures = options.processes == 0
+                ? runBatch(headers, output, options.analyzer)
+                : runProcessBatch(headers, output, options.analyzer, options.processes,
+                                  std::chrono::milliseconds(options.timeoutMs));
+            if (database) {
+                database->finish();
+            }
+            return failures == 0 ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // Include profile mode reports which includes make the headers expensive to parse
+    if (options.profileMode) {
+        if (positional.size() < 2) {
+            printUsage(program);
+            return 1;
+        }
+        std::vector<std::string> headers(positional.begin(), positional.end() - 1);
+        try {
+            IncludeProfiler profiler(headers, options.analyzer);
+            for (const auto& profile : profiler.getProfiles()) {
+                if (!profile.error.empty()) {
+                    std::cerr << "Error: " << profile.header << ": " << profile.error << std::endl;
+                }
+            }
+            profiler.writeReport(positional.back());
+            if (!options.flameGraphFile.empty()) {
+                profiler.writeFoldedStacks(options.flameGraphFile);
+            }
+            return profiler.getFailureCount() == 0 ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // Diff mode compares two versions of a header
+    if (options.diffMode) {
+        if (positional.size() != 3) {
+            printUsage(program);
+            return 1;
+        }
+        try {
+            HeaderAnalyzer before = loadOrAnalyze(positional[0], options.analyzer);
+            HeaderAnalyzer after = loadOrAnalyze(positional[1], options.analyzer);
+            HeaderDiff diff(before, after);
+            diff.writeToXML(positional[2], compression);
+            if (options.printStats) {
+                printStatistics(positional[0], before);
+                printStatistics(positional[1], after);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-int main(int argc, char* argv[]) {
     // Check if the correct number of arguments is provided
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <input_header_file> <output_xml_file>" << std::endl;
+    if (positional.size() != 2) {
+        printUsage(program);
         return 1;
     }
 
     // Retrieve the input and output file names from command line arguments
-    std::string inputHeaderFile = argv[1];
-    std::string outputXMLFile = argv[2];
+    std::string inputHeaderFile = positional[0];
+    std::string outputXMLFile = positional[1];
+
+    // Multi-configuration mode stores declarations shared by all configurations once
+    if (!options.configurations.empty()) {
+        try {
+            MultiConfigAnalyzer analyzer(inputHeaderFile, options.configurations, options.analyzer);
+            analyzer.writeToXML(outputXMLFile, compression);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
     try {
         // Create an instance of HeaderAnalyzer with the input header file
-        HeaderAnalyzer analyzer(inputHeaderFile);
+        HeaderAnalyzer analyzer(inputHeaderFile, options.analyzer);
+
+        // Write the analyzed information to the specified XML output file, or generate code from it
+        if (!options.enumTablesNamespace.empty()) {
+            EnumTableGenerator(analyzer, options.enumTablesNamespace).writeToHeader(outputXMLFile);
+        } else if (!options.serializersNamespace.empty()) {
+            StructSerializerGenerator(analyzer, options.serializersNamespace, inputHeaderFile).writeToHeader(outputXMLFile);
+        } else if (options.sqliteMode) {
+            SQLiteExporter database(outputXMLFile);
+            database.add(analyzer);
+            database.finish();
+        } else if (!analyzer.writeToXML(outputXMLFile, compression, options.serializeThreads)) {
+            return 1;
+        }
 
-        // Write the analyzed information to the specified XML output file
-        analyzer.writeToXML(outputXMLFile);
+        if (options.printStats) {
+            printStatistics(inputHeaderFile, analyzer);
+        }
 
         // Indicate successful processing
         // std::cout << "Successfully processed " << inputHeaderFile << " and wrote to " << outputXMLFile << std::endl;
@@ -30,3 +383,95 @@ int main(int argc, char* argv[]) {
 
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    CommandLine options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--diff") {
+            options.diffMode = true;
+        } else if (arg == "--batch") {
+            options.batchMode = true;
+        } else if (arg == "--sqlite") {
+            if (!SQLiteExporter::isSupported()) {
+                std::cerr << "SQLite export not supported by this build" << std::endl;
+                return 1;
+            }
+            options.sqliteMode = true;
+        } else if (arg == "--include-profile") {
+            options.profileMode = true;
+        } else if (arg.compare(0, 13, "--flamegraph=") == 0) {
+            options.flameGraphFile = arg.substr(13);
+        } else if (arg.compare(0, 12, "--processes=") == 0) {
+            long count = 0;
+            if (!parseCount(arg.substr(12), count)) {
+                std::cerr << "Invalid process count: " << arg.substr(12) << std::endl;
+                return 1;
+            }
+            options.processes = static_cast<size_t>(count);
+        } else if (arg.compare(0, 20, "--serialize-threads=") == 0) {
+            long count = 0;
+            if (!parseCount(arg.substr(20), count)) {
+                std::cerr << "Invalid thread count: " << arg.substr(20) << std::endl;
+                return 1;
+            }
+            options.serializeThreads = static_cast<size_t>(count);
+        } else if (arg.compare(0, 10, "--timeout=") == 0) {
+            if (!parseCount(arg.substr(10), options.timeoutMs)) {
+                std::cerr << "Invalid timeout: " << arg.substr(10) << std::endl;
+                return 1;
+            }
+        } else if (arg == "--enum-tables") {
+            options.enumTablesNamespace = "header_enums";
+        } else if (arg.compare(0, 14, "--enum-tables=") == 0) {
+            options.enumTablesNamespace = arg.substr(14);
+        } else if (arg == "--struct-serializers") {
+            options.serializersNamespace = "header_serializers";
+        } else if (arg.compare(0, 21, "--struct-serializers=") == 0) {
+            options.serializersNamespace = arg.substr(21);
+        } else if (arg.compare(0, 8, "--trace=") == 0) {
+            options.traceFile = arg.substr(8);
+        } else if (arg == "--stats") {
+            options.printStats = true;
+        } else if (arg.compare(0, 11, "--compress=") == 0) {
+            if (!parseCompression(arg.substr(11), options.compression)) {
+                std::cerr << "Unknown compression format: " << arg.substr(11) << std::endl;
+                return 1;
+            }
+        } else if (arg.compare(0, 8, "--kinds=") == 0) {
+            unsigned kinds = 0;
+            if (!parseKinds(arg.substr(8), kinds)) {
+                std::cerr << "Unknown declaration kind in: " << arg.substr(8) << std::endl;
+                return 1;
+            }
+            options.analyzer.filter.setKinds(kinds);
+        } else if (arg.compare(0, 17, "--include-prefix=") == 0) {
+            options.analyzer.filter.addIncludePrefix(arg.substr(17));
+        } else if (arg.compare(0, 17, "--exclude-prefix=") == 0) {
+            options.analyzer.filter.addExcludePrefix(arg.substr(17));
+        } else if (arg.compare(0, 16, "--include-regex=") == 0) {
+            if (!addPattern(options.analyzer.filter, arg.substr(16), true)) return 1;
+        } else if (arg.compare(0, 16, "--exclude-regex=") == 0) {
+            if (!addPattern(options.analyzer.filter, arg.substr(16), false)) return 1;
+        } else if (arg.compare(0, 9, "--config=") == 0) {
+            options.configurations.push_back(parseConfiguration(arg.substr(9)));
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            options.positional.push_back(arg);
+        }
+    }
+
+    // Spans are only recorded once tracing is enabled
+    if (!options.traceFile.empty()) {
+        TraceRecorder::setThreadName("main");
+        TraceRecorder::shared().setEnabled(true);
+    }
+    int status = run(options, argv[0]);
+    if (!options.traceFile.empty()) {
+        TraceRecorder::shared().writeToJSON(options.traceFile);
+    }
+    return status;
+}
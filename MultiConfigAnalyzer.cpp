@@ -0,0 +1,183 @@
+#include "MultiConfigAnalyzer.h"
+#include "DeclarationKeys.h"
+#include "HeaderDiff.h"
+#include "TraceRecorder.h"
+#include <future>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+struct KeyState {
+    uint64_t fingerprint = 0;
+    size_t count = 0;
+    bool identical = true;
+};
+
+// The declarations of one analyzer, collected before it is built with fromDeclarations
+struct Declarations {
+    std::vector<HeaderAnalyzer::EnumInfo> enums;
+    std::vector<HeaderAnalyzer::StructInfo> structs;
+    std::vector<HeaderAnalyzer::FunctionInfo> functions;
+    std::vector<HeaderAnalyzer::VariableInfo> variables;
+    std::vector<HeaderAnalyzer::TypedefInfo> typedefs;
+
+    HeaderAnalyzer build(const std::string& filename) {
+        return HeaderAnalyzer::fromDeclarations(filename, std::move(enums), std::move(structs), std::move(functions),
+                                                std::move(variables), std::move(typedefs));
+    }
+};
+
+// Copies declarations that are identical in every result into common, and the rest into the
+// matching specific set. Common declarations keep the order of the first configuration.
+template <typename Info, typename NameFn>
+void splitDeclarations(const std::vector<HeaderAnalyzer>& results, const std::vector<Info>& (HeaderAnalyzer::*get)() const,
+                       std::vector<Info> Declarations::*member, NameFn getName,
+                       Declarations& common, std::vector<Declarations>& specific) {
+    std::vector<std::vector<std::string>> keys;
+    keys.reserve(results.size());
+    std::unordered_map<std::string, KeyState> states;
+    for (const auto& result : results) {
+        const std::vector<Info>& declarations = (result.*get)();
+        keys.push_back(makeDeclarationKeys(declarations, getName));
+        for (size_t i = 0; i < declarations.size(); ++i) {
+            KeyState& state = states[keys.back()[i]];
+            uint64_t fingerprint = HeaderDiff::fingerprint(declarations[i]);
+            if (state.count == 0) {
+                state.fingerprint = fingerprint;
+            } else if (state.fingerprint != fingerprint) {
+                state.identical = false;
+            }
+            ++state.count;
+        }
+    }
+
+    for (size_t c = 0; c < results.size(); ++c) {
+        const std::vector<Info>& declarations = (results[c].*get)();
+        for (size_t i = 0; i < declarations.size(); ++i) {
+            const KeyState& state = states[keys[c][i]];
+            if (state.identical && state.count == results.size()) {
+                if (c == 0) {
+                    (common.*member).push_back(declarations[i]);
+                }
+            } else {
+                (specific[c].*member).push_back(declarations[i]);
+            }
+        }
+    }
+}
+
+std::string joinDefines(const std::vector<std::string>& defines) {
+    std::string result;
+    for (const auto& define : defines) {
+        result += (result.empty() ? "" : ";") + define;
+    }
+    return result;
+}
+
+} // namespace
+
+MultiConfigAnalyzer::MultiConfigAnalyzer(const std::string& filename, const std::vector<Configuration>& configurations)
+    : MultiConfigAnalyzer(filename, configurations, HeaderAnalyzer::Options()) {
+}
+
+MultiConfigAnalyzer::MultiConfigAnalyzer(const std::string& filename, const std::vector<Configuration>& configurations,
+                                         const HeaderAnalyzer::Options& options)
+    : m_configurations(configurations), m_common(HeaderAnalyzer::fromDeclarations(filename, {}, {}, {}, {}, {})) {
+    // Start every configuration first so that they are parsed concurrently
+    std::vector<std::future<HeaderAnalyzer>> futures;
+    futures.reserve(configurations.size());
+    for (const auto& configuration : configurations) {
+        futures.push_back(HeaderAnalyzer::analyzeAsync(filename, makeOptions(options, configuration)));
+    }
+
+    std::vector<HeaderAnalyzer> results;
+    results.reserve(futures.size());
+    for (auto& future : futures) {
+        results.push_back(future.get());
+    }
+
+    split(filename, results);
+}
+
+const std::vector<MultiConfigAnalyzer::Configuration>& MultiConfigAnalyzer::getConfigurations() const { return m_configurations; }
+const HeaderAnalyzer& MultiConfigAnalyzer::getCommon() const { return m_common; }
+const HeaderAnalyzer& MultiConfigAnalyzer::getSpecific(size_t index) const { return m_specific.at(index); }
+
+HeaderAnalyzer::Options MultiConfigAnalyzer::makeOptions(const HeaderAnalyzer::Options& base, const Configuration& configuration) {
+    HeaderAnalyzer::Options options = base;
+    if (!configuration.targetTriple.empty()) {
+        options.arguments.push_back("--target=" + configuration.targetTriple);
+    }
+    for (const auto& define : configuration.defines) {
+        options.arguments.push_back("-D" + define);
+    }
+    return options;
+}
+
+void MultiConfigAnalyzer::split(const std::string& filename, const std::vector<HeaderAnalyzer>& results) {
+    Declarations common;
+    std::vector<Declarations> specific(results.size());
+    splitDeclarations(results, &HeaderAnalyzer::getEnums, &Declarations::enums,
+                      [](const HeaderAnalyzer::EnumInfo& info) -> const std::string& { return info.name; },
+                      common, specific);
+    splitDeclarations(results, &HeaderAnalyzer::getTypedefs, &Declarations::typedefs,
+                      [](const HeaderAnalyzer::TypedefInfo& info) -> const std::string& { return info.newName; },
+                      common, specific);
+    splitDeclarations(results, &HeaderAnalyzer::getStructs, &Declarations::structs,
+                      [](const HeaderAnalyzer::StructInfo& info) -> const std::string& { return info.name; },
+                      common, specific);
+    splitDeclarations(results, &HeaderAnalyzer::getVariables, &Declarations::variables,
+                      [](const HeaderAnalyzer::VariableInfo& info) -> const std::string& { return info.name; },
+                      common, specific);
+    splitDeclarations(results, &HeaderAnalyzer::getFunctions, &Declarations::functions,
+                      [](const HeaderAnalyzer::FunctionInfo& info) -> const std::string& { return info.name; },
+                      common, specific);
+
+    m_common = common.build(filename);
+    m_specific.reserve(results.size());
+    for (size_t c = 0; c < results.size(); ++c) {
+        m_specific.push_back(specific[c].build(results[c].getFilename()));
+    }
+}
+
+void MultiConfigAnalyzer::writeToXML(const std::string& outputFilename, Compression compression) const {
+    TraceRecorder::Span span("serialize", m_common.getFilename());
+    CompressedFileWriter outFile(outputFilename, compression);
+    if (!outFile.isOpen()) {
+        std::cerr << outFile.getError() << std::endl;
+        return;
+    }
+
+    // Start XML document
+    std::string xml;
+    xml += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    xml += "<multi-config-header>\n";
+
+    xml += "  <configurations>\n";
+    for (const auto& configuration : m_configurations) {
+        xml += "    <configuration name=\"" + configuration.name + "\" target=\"" + configuration.targetTriple +
+               "\" defines=\"" + joinDefines(configuration.defines) + "\"/>\n";
+    }
+    xml += "  </configurations>\n";
+
+    // Declarations shared by every configuration
+    xml += "  <common>\n";
+    m_common.writeSectionsXML(xml, outFile);
+    xml += "  </common>\n";
+
+    // Per-configuration differences
+    for (size_t c = 0; c < m_configurations.size(); ++c) {
+        xml += "  <specific configuration=\"" + m_configurations[c].name + "\">\n";
+        m_specific[c].writeSectionsXML(xml, outFile);
+        xml += "  </specific>\n";
+    }
+
+    // End XML document
+    xml += "</multi-config-header>\n";
+    outFile.write(std::move(xml));
+
+    if (!outFile.close()) {
+        std::cerr << outFile.getError() << std::endl;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "HeaderAnalyzer.h"
+#include <string>
+#include <vector>
+
+/**
+ * @class MultiConfigAnalyzer
+ * @brief Analyzes one header under several target triples and define sets at once.
+ *
+ * Every configuration is analyzed concurrently on the shared executor. Declarations that come
+ * out identical (same name and fingerprint) in all configurations are stored once as the common
+ * set; each configuration only keeps the declarations that differ from it or exist only there.
+ */
+class MultiConfigAnalyzer {
+public:
+    /**
+     * @struct Configuration
+     * @brief Describes one target/define combination to analyze the header under.
+     */
+    struct Configuration {
+        std::string name; /**< A label for the configuration, used in the output (e.g., "aarch64"). */
+        std::string targetTriple; /**< The clang target triple, empty for the host target. */
+        std::vector<std::string> defines; /**< Macros to define, as "NAME" or "NAME=VALUE". */
+    };
+
+    /**
+     * @brief Analyzes a header under each of the given configurations.
+     * @param filename The path to the header file to analyze.
+     * @param configurations The configurations to analyze the header under.
+     * @throws std::runtime_error If the header cannot be parsed under one of the configurations. The
+     *         error of the first such configuration, in the given order, is rethrown.
+     */
+    MultiConfigAnalyzer(const std::string& filename, const std::vector<Configuration>& configurations);
+
+    /**
+     * @brief Analyzes a header under each configuration, on top of shared base options.
+     * @param filename The path to the header file to analyze.
+     * @param configurations The configurations to analyze the header under.
+     * @param options Options shared by all configurations, such as include paths.
+     * @throws std::runtime_error If the header cannot be parsed under one of the configurations. The
+     *         error of the first such configuration, in the given order, is rethrown.
+     */
+    MultiConfigAnalyzer(const std::string& filename, const std::vector<Configuration>& configurations,
+                        const HeaderAnalyzer::Options& options);
+
+    /**
+     * @brief Retrieves the configurations the header was analyzed under.
+     * @return A constant reference to the vector of configurations.
+     */
+    const std::vector<Configuration>& getConfigurations() const;
+
+    /**
+     * @brief Retrieves the declarations that are identical in every configuration.
+     * @return A constant reference to an analyzer holding the common declarations.
+     */
+    const HeaderAnalyzer& getCommon() const;
+
+    /**
+     * @brief Retrieves the declarations of one configuration that are not in the common set.
+     * @param index The index of the configuration, in the order given to the constructor.
+     * @return A constant reference to an analyzer holding the configuration-specific declarations.
+     */
+    const HeaderAnalyzer& getSpecific(size_t index) const;
+
+    /**
+     * @brief Writes the common and configuration-specific declarations to an XML file.
+     * @param outputFilename The name of the output XML file.
+     * @param compression The compression to apply, by default chosen from the extension (".gz", ".zst").
+     */
+    void writeToXML(const std::string& outputFilename, Compression compression = Compression::Auto) const;
+
+private:
+    std::vector<Configuration> m_configurations;
+    HeaderAnalyzer m_common;
+    std::vector<HeaderAnalyzer> m_specific;
+
+    void split(const std::string& filename, const std::vector<HeaderAnalyzer>& results);
+    static HeaderAnalyzer::Options makeOptions(const HeaderAnalyzer::Options& base, const Configuration& configuration);
+};
@@ -0,0 +1,513 @@
+#include "ProcessPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Protocol, all integers little-endian:
+//   request:  u32 length, filename bytes
+//   response: u8 status (0 = declarations, 1 = error message), u64 length, payload bytes
+const size_t kResponseHeaderSize = 9;
+const size_t kReadChunkSize = 1 << 16;
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        // MSG_NOSIGNAL: a dead peer must show up as an error, not as SIGPIPE
+        ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Returns false on end of stream or error
+bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = read(fd, data, size);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+void putFixed(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+uint64_t getFixed(const char* data, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+// Declarations are encoded as LEB128 varints and length-prefixed strings, which keeps the
+// mostly small counts, values and names compact.
+class BinaryWriter {
+public:
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            m_out += static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        m_out += static_cast<char>(value);
+    }
+
+    void signedVarint(int64_t value) {
+        varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void string(const std::string& value) {
+        varint(value.size());
+        m_out += value;
+    }
+
+    std::string& output() { return m_out; }
+
+private:
+    std::string m_out;
+};
+
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t size) : m_pos(data), m_end(data + size) {}
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_pos == m_end) fail();
+            unsigned char byte = static_cast<unsigned char>(*m_pos++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        fail();
+    }
+
+    int64_t signedVarint() {
+        uint64_t value = varint();
+        return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    std::string string() {
+        uint64_t size = varint();
+        if (size > static_cast<uint64_t>(m_end - m_pos)) fail();
+        std::string value(m_pos, static_cast<size_t>(size));
+        m_pos += size;
+        return value;
+    }
+
+    // Counts are bounded by the remaining input, so a corrupt count cannot trigger a huge allocation
+    size_t count() {
+        uint64_t value = varint();
+        if (value > static_cast<uint64_t>(m_end - m_pos)) fail();
+        return static_cast<size_t>(value);
+    }
+
+    bool atEnd() const { return m_pos == m_end; }
+
+private:
+    const char* m_pos;
+    const char* m_end;
+
+    [[noreturn]] static void fail() {
+        throw std::runtime_error("Malformed result received from analyzer worker");
+    }
+};
+
+} // namespace
+
+ProcessPool::ProcessPool(size_t processCount, std::chrono::milliseconds timeout)
+    : ProcessPool(processCount, timeout, HeaderAnalyzer::Options()) {
+}
+
+ProcessPool::ProcessPool(size_t processCount, std::chrono::milliseconds timeout, const HeaderAnalyzer::Options& options)
+    : m_timeout(timeout), m_options(options) {
+    m_workers.resize(std::max<size_t>(processCount, 1));
+    try {
+        for (auto& worker : m_workers) {
+            startWorker(worker);
+        }
+    } catch (...) {
+        for (auto& worker : m_workers) {
+            stopWorker(worker, true);
+        }
+        throw;
+    }
+}
+
+ProcessPool::~ProcessPool() {
+    // Idle workers exit when their socket is closed; busy ones are killed
+    for (auto& worker : m_workers) {
+        stopWorker(worker, worker.busy);
+    }
+}
+
+void ProcessPool::startWorker(Worker& worker) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        throw std::runtime_error(std::string("Unable to create worker socket: ") + std::strerror(errno));
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(sockets[0]);
+        close(sockets[1]);
+        throw std::runtime_error(std::string("Unable to start worker process: ") + std::strerror(errno));
+    }
+    if (pid == 0) {
+        close(sockets[0]);
+        // Do not keep the other workers' sockets open, or they would not see end of stream
+        for (auto& other : m_workers) {
+            if (other.socket >= 0) close(other.socket);
+        }
+        workerMain(sockets[1]);
+    }
+
+    close(sockets[1]);
+    worker.pid = pid;
+    worker.socket = sockets[0];
+    worker.busy = false;
+    worker.response.clear();
+}
+
+void ProcessPool::stopWorker(Worker& worker, bool kill) {
+    if (worker.pid < 0) {
+        return;
+    }
+    close(worker.socket);
+    if (kill) {
+        ::kill(worker.pid, SIGKILL);
+    }
+    while (waitpid(worker.pid, nullptr, 0) < 0 && errno == EINTR) {
+    }
+    worker.pid = -1;
+    worker.socket = -1;
+    worker.busy = false;
+}
+
+std::string ProcessPool::describeExit(Worker& worker) {
+    close(worker.socket);
+    int status = 0;
+    while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    worker.pid = -1;
+    worker.socket = -1;
+    worker.busy = false;
+
+    if (WIFSIGNALED(status)) {
+        return "Analyzer worker crashed with signal " + std::to_string(WTERMSIG(status)) + " (" +
+               strsignal(WTERMSIG(status)) + ")";
+    }
+    return "Analyzer worker exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+void ProcessPool::workerMain(int socket) {
+    for (;;) {
+        char lengthBytes[4];
+        if (!readAll(socket, lengthBytes, sizeof(lengthBytes))) {
+            _exit(0); // The pool closed the socket
+        }
+        std::string filename(static_cast<size_t>(getFixed(lengthBytes, 4)), '\0');
+        if (!readAll(socket, &filename[0], filename.size())) {
+            _exit(0);
+        }
+
+        char status = 0;
+        std::string payload;
+        try {
+            payload = encode(HeaderAnalyzer(filename, m_options));
+        } catch (const std::exception& e) {
+            status = 1;
+            payload = e.what();
+        }
+
+        std::string response(1, status);
+        putFixed(response, payload.size(), 8);
+        if (!writeAll(socket, response.data(), response.size()) || !writeAll(socket, payload.data(), payload.size())) {
+            _exit(1);
+        }
+    }
+}
+
+std::vector<ProcessPool::Result> ProcessPool::analyze(const std::vector<std::string>& filenames) {
+    std::vector<Result> results(filenames.size());
+    dispatch(filenames, [&results](size_t index, Result result) { results[index] = std::move(result); });
+    return results;
+}
+
+void ProcessPool::analyze(const std::vector<std::string>& filenames, const ResultCallback& callback) {
+    dispatch(filenames, [&callback](size_t, Result result) { callback(std::move(result)); });
+}
+
+void ProcessPool::dispatch(const std::vector<std::string>& filenames, const std::function<void(size_t, Result)>& onResult) {
+    size_t next = 0;
+    size_t remaining = filenames.size();
+
+    auto fail = [&](Worker& worker, std::string error) {
+        Result result;
+        result.filename = filenames[worker.task];
+        result.error = std::move(error);
+        --remaining;
+        onResult(worker.task, std::move(result));
+        startWorker(worker);
+        ++m_restarts;
+    };
+
+    std::vector<pollfd> pollfds;
+    std::vector<Worker*> polled;
+    while (remaining > 0) {
+        // Hand out headers to idle workers
+        for (auto& worker : m_workers) {
+            if (worker.busy || next == filenames.size()) {
+                continue;
+            }
+            std::string request;
+            putFixed(request, filenames[next].size(), 4);
+            request += filenames[next];
+            if (!writeAll(worker.socket, request.data(), request.size())) {
+                // The worker died while idle; replace it and try once more
+                describeExit(worker);
+                startWorker(worker);
+                ++m_restarts;
+                if (!writeAll(worker.socket, request.data(), request.size())) {
+                    throw std::runtime_error("Unable to send header to analyzer worker");
+                }
+            }
+            worker.busy = true;
+            worker.task = next++;
+            worker.deadline = std::chrono::steady_clock::now() + m_timeout;
+            worker.response.clear();
+        }
+
+        // Wait for a response or for the earliest deadline
+        pollfds.clear();
+        polled.clear();
+        int waitMs = -1;
+        auto now = std::chrono::steady_clock::now();
+        for (auto& worker : m_workers) {
+            if (!worker.busy) continue;
+            pollfds.push_back({worker.socket, POLLIN, 0});
+            polled.push_back(&worker);
+            if (m_timeout.count() > 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(worker.deadline - now).count() + 1;
+                int leftMs = static_cast<int>(std::max<long long>(left, 0));
+                waitMs = waitMs < 0 ? leftMs : std::min(waitMs, leftMs);
+            }
+        }
+        if (poll(pollfds.data(), pollfds.size(), waitMs) < 0 && errno != EINTR) {
+            throw std::runtime_error(std::string("Unable to wait for analyzer workers: ") + std::strerror(errno));
+        }
+
+        now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < pollfds.size(); ++i) {
+            Worker& worker = *polled[i];
+            if (pollfds[i].revents != 0) {
+                char buffer[kReadChunkSize];
+                ssize_t received = read(worker.socket, buffer, sizeof(buffer));
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (received <= 0) {
+                    fail(worker, describeExit(worker));
+                    continue;
+                }
+                worker.response.append(buffer, static_cast<size_t>(received));
+
+                const std::string& response = worker.response;
+                if (response.size() < kResponseHeaderSize) {
+                    continue;
+                }
+                uint64_t payloadSize = getFixed(response.data() + 1, 8);
+                if (response.size() - kResponseHeaderSize < payloadSize) {
+                    continue;
+                }
+
+                Result result;
+                result.filename = filenames[worker.task];
+                const char* payload = response.data() + kResponseHeaderSize;
+                if (response[0] == 0) {
+                    try {
+                        result.analyzer = decode(result.filename, payload, static_cast<size_t>(payloadSize));
+                    } catch (const std::exception& e) {
+                        result.error = e.what();
+                    }
+                } else {
+                    result.error.assign(payload, static_cast<size_t>(payloadSize));
+                }
+                worker.busy = false;
+                worker.response.clear();
+                --remaining;
+                onResult(worker.task, std::move(result));
+            } else if (m_timeout.count() > 0 && now >= worker.deadline) {
+                stopWorker(worker, true);
+                fail(worker, "Analyzer worker timed out after " + std::to_string(m_timeout.count()) + " ms");
+            }
+        }
+    }
+}
+
+std::string ProcessPool::encode(const HeaderAnalyzer& analyzer) {
+    BinaryWriter out;
+
+    out.varint(analyzer.getEnums().size());
+    for (const auto& info : analyzer.getEnums()) {
+        out.string(info.name);
+        out.varint(info.enumerators.size());
+        for (const auto& enumerator : info.enumerators) {
+            out.string(enumerator.first);
+            out.signedVarint(enumerator.second);
+        }
+        out.string(info.underlyingType);
+        out.string(info.comment);
+    }
+
+    out.varint(analyzer.getStructs().size());
+    for (const auto& info : analyzer.getStructs()) {
+        out.string(info.name);
+        out.varint(info.members.size());
+        for (const auto& member : info.members) {
+            out.string(member.name);
+            out.string(member.type);
+            out.signedVarint(member.bitfieldWidth);
+            out.signedVarint(member.offset);
+            out.signedVarint(member.size);
+            out.string(member.canonicalType);
+        }
+        out.string(info.comment);
+        out.signedVarint(info.size);
+        out.signedVarint(info.alignment);
+        out.varint(info.tagged ? 1 : 0);
+        out.string(info.parent);
+    }
+
+    out.varint(analyzer.getFunctions().size());
+    for (const auto& info : analyzer.getFunctions()) {
+        out.string(info.name);
+        out.string(info.returnType);
+        out.varint(info.parameters.size());
+        for (const auto& parameter : info.parameters) {
+            out.string(parameter.first);
+            out.string(parameter.second);
+        }
+        out.string(info.attributes);
+        out.varint(info.isVariadic ? 1 : 0);
+        out.string(info.comment);
+    }
+
+    out.varint(analyzer.getVariables().size());
+    for (const auto& info : analyzer.getVariables()) {
+        out.string(info.name);
+        out.string(info.type);
+        out.string(info.value);
+        out.string(info.storageClass);
+        out.string(info.qualifiers);
+        out.varint(info.arrayDimensions.size());
+        for (int dimension : info.arrayDimensions) {
+            out.signedVarint(dimension);
+        }
+        out.string(info.comment);
+    }
+
+    out.varint(analyzer.getTypedefs().size());
+    for (const auto& info : analyzer.getTypedefs()) {
+        out.string(info.newName);
+        out.string(info.originalType);
+        out.string(info.qualifiers);
+        out.string(info.comment);
+    }
+
+    return std::move(out.output());
+}
+
+std::unique_ptr<HeaderAnalyzer> ProcessPool::decode(const std::string& filename, const char* data, size_t size) {
+    BinaryReader in(data, size);
+
+    std::vector<HeaderAnalyzer::EnumInfo> enums(in.count());
+    for (auto& info : enums) {
+        info.name = in.string();
+        info.enumerators.resize(in.count());
+        for (auto& enumerator : info.enumerators) {
+            enumerator.first = in.string();
+            enumerator.second = in.signedVarint();
+        }
+        info.underlyingType = in.string();
+        info.comment = in.string();
+    }
+
+    std::vector<HeaderAnalyzer::StructInfo> structs(in.count());
+    for (auto& info : structs) {
+        info.name = in.string();
+        info.members.resize(in.count());
+        for (auto& member : info.members) {
+            member.name = in.string();
+            member.type = in.string();
+            member.bitfieldWidth = static_cast<int>(in.signedVarint());
+            member.offset = in.signedVarint();
+            member.size = in.signedVarint();
+            member.canonicalType = in.string();
+        }
+        info.comment = in.string();
+        info.size = in.signedVarint();
+        info.alignment = in.signedVarint();
+        info.tagged = in.varint() != 0;
+        info.parent = in.string();
+    }
+
+    std::vector<HeaderAnalyzer::FunctionInfo> functions(in.count());
+    for (auto& info : functions) {
+        info.name = in.string();
+        info.returnType = in.string();
+        info.parameters.resize(in.count());
+        for (auto& parameter : info.parameters) {
+            parameter.first = in.string();
+            parameter.second = in.string();
+        }
+        info.attributes = in.string();
+        info.isVariadic = in.varint() != 0;
+        info.comment = in.string();
+    }
+
+    std::vector<HeaderAnalyzer::VariableInfo> variables(in.count());
+    for (auto& info : variables) {
+        info.name = in.string();
+        info.type = in.string();
+        info.value = in.string();
+        info.storageClass = in.string();
+        info.qualifiers = in.string();
+        info.arrayDimensions.resize(in.count());
+        for (int& dimension : info.arrayDimensions) {
+            dimension = static_cast<int>(in.signedVarint());
+        }
+        info.comment = in.string();
+    }
+
+    std::vector<HeaderAnalyzer::TypedefInfo> typedefs(in.count());
+    for (auto& info : typedefs) {
+        info.newName = in.string();
+        info.originalType = in.string();
+        info.qualifiers = in.string();
+        info.comment = in.string();
+    }
+
+    if (!in.atEnd()) {
+        throw std::runtime_error("Malformed result received from analyzer worker");
+    }
+    return std::unique_ptr<HeaderAnalyzer>(new HeaderAnalyzer(HeaderAnalyzer::fromDeclarations(
+        filename, std::move(enums), std::move(structs), std::move(functions), std::move(variables), std::move(typedefs))));
+}
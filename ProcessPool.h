@@ -0,0 +1,115 @@
+#pragma once
+
+#include "HeaderAnalyzer.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @class ProcessPool
+ * @brief Analyzes headers in forked worker processes, so that a crash only loses one header.
+ *
+ * The pool forks a fixed number of long-lived workers. Each header is sent to an idle worker
+ * over a socket pair, the worker analyzes it with HeaderAnalyzer and streams the declarations
+ * back in a compact binary encoding. A worker that crashes, or that exceeds the deadline and is
+ * killed, is replaced by a fresh one and the header it was working on is reported as failed.
+ *
+ * Workers are forked from the calling process, so the pool should be created, and used, while
+ * no other threads hold locks (e.g. before starting the shared executor).
+ *
+ * Trace spans recorded inside the workers stay in the workers and are not part of the trace
+ * TraceRecorder::shared() writes in the calling process.
+ */
+class ProcessPool {
+public:
+    /**
+     * @struct Result
+     * @brief The outcome of analyzing one header.
+     */
+    struct Result {
+        std::string filename; /**< The header that was analyzed. */
+        std::unique_ptr<HeaderAnalyzer> analyzer; /**< The declarations, null if the analysis failed. */
+        std::string error; /**< Why the analysis failed: a parse error, a crash or a timeout. */
+    };
+
+    /**
+     * @brief Callback receiving each result as soon as its worker finishes.
+     */
+    using ResultCallback = std::function<void(Result result)>;
+
+    /**
+     * @brief Forks the worker processes.
+     * @param processCount The number of workers, at least one is always started.
+     * @param timeout The time a worker may spend on one header before it is killed, zero for no limit.
+     * @throws std::runtime_error If a worker cannot be started.
+     */
+    ProcessPool(size_t processCount, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Forks the worker processes, which parse every header with the given options.
+     * @param processCount The number of workers, at least one is always started.
+     * @param timeout The time a worker may spend on one header before it is killed, zero for no limit.
+     * @param options The options controlling how each header is parsed.
+     * @throws std::runtime_error If a worker cannot be started.
+     */
+    ProcessPool(size_t processCount, std::chrono::milliseconds timeout, const HeaderAnalyzer::Options& options);
+
+    /**
+     * @brief Stops and reaps all worker processes.
+     */
+    ~ProcessPool();
+
+    ProcessPool(const ProcessPool&) = delete;
+    ProcessPool& operator=(const ProcessPool&) = delete;
+
+    /**
+     * @brief Analyzes headers and returns the results in the order of the input.
+     * @param filenames The headers to analyze.
+     * @return One result per header.
+     */
+    std::vector<Result> analyze(const std::vector<std::string>& filenames);
+
+    /**
+     * @brief Analyzes headers and passes each result to a callback as soon as it is available.
+     *
+     * Results arrive in completion order. The callback runs on the calling thread.
+     *
+     * @param filenames The headers to analyze.
+     * @param callback The callback receiving each result.
+     */
+    void analyze(const std::vector<std::string>& filenames, const ResultCallback& callback);
+
+    /**
+     * @brief Retrieves how many workers were replaced after a crash or timeout.
+     * @return The number of restarted workers.
+     */
+    size_t getRestartCount() const { return m_restarts; }
+
+private:
+    struct Worker {
+        pid_t pid = -1;
+        int socket = -1;
+        bool busy = false;
+        size_t task = 0;                                // Index of the header being analyzed
+        std::chrono::steady_clock::time_point deadline; // When the worker is killed
+        std::string response;                           // Partially received response
+    };
+
+    std::chrono::milliseconds m_timeout;
+    HeaderAnalyzer::Options m_options;
+    std::vector<Worker> m_workers;
+    size_t m_restarts = 0;
+
+    void dispatch(const std::vector<std::string>& filenames, const std::function<void(size_t, Result)>& onResult);
+    void startWorker(Worker& worker);
+    void stopWorker(Worker& worker, bool kill);
+    std::string describeExit(Worker& worker);
+    [[noreturn]] void workerMain(int socket);
+
+    // Binary encoding of the analyzed declarations sent from a worker to the pool
+    static std::string encode(const HeaderAnalyzer& analyzer);
+    static std::unique_ptr<HeaderAnalyzer> decode(const std::string& filename, const char* data, size_t size);
+};
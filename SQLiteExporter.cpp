@@ -0,0 +1,305 @@
+#include "SQLiteExporter.h"
+#include <stdexcept>
+#ifdef HEADER_ANALYZER_WITH_SQLITE
+#include <sqlite3.h>
+
+namespace {
+
+const char* kSchema =
+    "CREATE TABLE IF NOT EXISTS headers ("
+    "id INTEGER PRIMARY KEY, path TEXT NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS enums ("
+    "id INTEGER PRIMARY KEY, header_id INTEGER NOT NULL REFERENCES headers(id), name TEXT NOT NULL, "
+    "underlying_type TEXT NOT NULL, comment TEXT NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS enumerators ("
+    "enum_id INTEGER NOT NULL REFERENCES enums(id), position INTEGER NOT NULL, name TEXT NOT NULL, "
+    "value INTEGER NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS structs ("
+    "id INTEGER PRIMARY KEY, header_id INTEGER NOT NULL REFERENCES headers(id), name TEXT NOT NULL, "
+    "size INTEGER, alignment INTEGER, comment TEXT NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS struct_members ("
+    "struct_id INTEGER NOT NULL REFERENCES structs(id), position INTEGER NOT NULL, name TEXT NOT NULL, "
+    "type TEXT NOT NULL, canonical_type TEXT NOT NULL, bitfield_width INTEGER, offset_bits INTEGER, size INTEGER);"
+    "CREATE TABLE IF NOT EXISTS functions ("
+    "id INTEGER PRIMARY KEY, header_id INTEGER NOT NULL REFERENCES headers(id), name TEXT NOT NULL, "
+    "return_type TEXT NOT NULL, is_variadic INTEGER NOT NULL, attributes TEXT NOT NULL, comment TEXT NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS function_parameters ("
+    "function_id INTEGER NOT NULL REFERENCES functions(id), position INTEGER NOT NULL, name TEXT NOT NULL, "
+    "type TEXT NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS variables ("
+    "id INTEGER PRIMARY KEY, header_id INTEGER NOT NULL REFERENCES headers(id), name TEXT NOT NULL, "
+    "type TEXT NOT NULL, value TEXT NOT NULL, storage_class TEXT NOT NULL, qualifiers TEXT NOT NULL, "
+    "comment TEXT NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS variable_dimensions ("
+    "variable_id INTEGER NOT NULL REFERENCES variables(id), position INTEGER NOT NULL, size INTEGER NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS typedefs ("
+    "id INTEGER PRIMARY KEY, header_id INTEGER NOT NULL REFERENCES headers(id), new_name TEXT NOT NULL, "
+    "original_type TEXT NOT NULL, qualifiers TEXT NOT NULL, comment TEXT NOT NULL);";
+
+// Dropped while rows are inserted and rebuilt by finish()
+const char* kDropIndexes =
+    "DROP INDEX IF EXISTS enums_name;"
+    "DROP INDEX IF EXISTS enums_header;"
+    "DROP INDEX IF EXISTS enumerators_enum;"
+    "DROP INDEX IF EXISTS structs_name;"
+    "DROP INDEX IF EXISTS structs_header;"
+    "DROP INDEX IF EXISTS struct_members_struct;"
+    "DROP INDEX IF EXISTS functions_name;"
+    "DROP INDEX IF EXISTS functions_header;"
+    "DROP INDEX IF EXISTS function_parameters_function;"
+    "DROP INDEX IF EXISTS variables_name;"
+    "DROP INDEX IF EXISTS variables_header;"
+    "DROP INDEX IF EXISTS variable_dimensions_variable;"
+    "DROP INDEX IF EXISTS typedefs_name;"
+    "DROP INDEX IF EXISTS typedefs_header;";
+
+const char* kCreateIndexes =
+    "CREATE INDEX IF NOT EXISTS enums_name ON enums(name);"
+    "CREATE INDEX IF NOT EXISTS enums_header ON enums(header_id);"
+    "CREATE INDEX IF NOT EXISTS enumerators_enum ON enumerators(enum_id);"
+    "CREATE INDEX IF NOT EXISTS structs_name ON structs(name);"
+    "CREATE INDEX IF NOT EXISTS structs_header ON structs(header_id);"
+    "CREATE INDEX IF NOT EXISTS struct_members_struct ON struct_members(struct_id);"
+    "CREATE INDEX IF NOT EXISTS functions_name ON functions(name);"
+    "CREATE INDEX IF NOT EXISTS functions_header ON functions(header_id);"
+    "CREATE INDEX IF NOT EXISTS function_parameters_function ON function_parameters(function_id);"
+    "CREATE INDEX IF NOT EXISTS variables_name ON variables(name);"
+    "CREATE INDEX IF NOT EXISTS variables_header ON variables(header_id);"
+    "CREATE INDEX IF NOT EXISTS variable_dimensions_variable ON variable_dimensions(variable_id);"
+    "CREATE INDEX IF NOT EXISTS typedefs_name ON typedefs(new_name);"
+    "CREATE INDEX IF NOT EXISTS typedefs_header ON typedefs(header_id);";
+
+// Indexed by SQLiteExporter::Statement
+const char* const kInsertStatements[] = {
+    "INSERT INTO headers (path) VALUES (?1)",
+    "INSERT INTO enums (header_id, name, underlying_type, comment) VALUES (?1, ?2, ?3, ?4)",
+    "INSERT INTO enumerators (enum_id, position, name, value) VALUES (?1, ?2, ?3, ?4)",
+    "INSERT INTO structs (header_id, name, size, alignment, comment) VALUES (?1, ?2, ?3, ?4, ?5)",
+    "INSERT INTO struct_members (struct_id, position, name, type, canonical_type, bitfield_width, offset_bits, size) "
+    "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8)",
+    "INSERT INTO functions (header_id, name, return_type, is_variadic, attributes, comment) VALUES (?1, ?2, ?3, ?4, ?5, ?6)",
+    "INSERT INTO function_parameters (function_id, position, name, type) VALUES (?1, ?2, ?3, ?4)",
+    "INSERT INTO variables (header_id, name, type, value, storage_class, qualifiers, comment) "
+    "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)",
+    "INSERT INTO variable_dimensions (variable_id, position, size) VALUES (?1, ?2, ?3)",
+    "INSERT INTO typedefs (header_id, new_name, original_type, qualifiers, comment) VALUES (?1, ?2, ?3, ?4, ?5)"
+};
+
+// The strings outlive the statement step, so SQLite does not need to copy them
+void bindText(sqlite3_stmt* statement, int index, const std::string& value) {
+    sqlite3_bind_text(statement, index, value.data(), static_cast<int>(value.size()), SQLITE_STATIC);
+}
+
+// Unknown layout values (-1) are stored as NULL
+void bindOptional(sqlite3_stmt* statement, int index, long long value) {
+    if (value < 0) {
+        sqlite3_bind_null(statement, index);
+    } else {
+        sqlite3_bind_int64(statement, index, value);
+    }
+}
+
+} // namespace
+
+SQLiteExporter::SQLiteExporter(const std::string& databaseFilename) {
+    if (sqlite3_open(databaseFilename.c_str(), &m_database) != SQLITE_OK) {
+        std::string error = "Unable to open database " + databaseFilename + ": " + sqlite3_errmsg(m_database);
+        sqlite3_close(m_database);
+        m_database = nullptr;
+        throw std::runtime_error(error);
+    }
+
+    try {
+        // A large page cache keeps the index builds in finish() in memory
+        execute("PRAGMA cache_size = -262144");
+        execute(kSchema);
+        execute("BEGIN");
+        execute(kDropIndexes);
+        for (int i = 0; i < StatementCount; ++i) {
+            if (sqlite3_prepare_v2(m_database, kInsertStatements[i], -1, &m_statements[i], nullptr) != SQLITE_OK) {
+                throwError("Unable to prepare statement");
+            }
+        }
+    } catch (...) {
+        close();
+        throw;
+    }
+}
+
+SQLiteExporter::~SQLiteExporter() {
+    close();
+}
+
+void SQLiteExporter::close() {
+    for (auto*& statement : m_statements) {
+        sqlite3_finalize(statement);
+        statement = nullptr;
+    }
+    // Closing with an open transaction rolls it back
+    sqlite3_close(m_database);
+    m_database = nullptr;
+}
+
+void SQLiteExporter::execute(const char* sql) {
+    if (sqlite3_exec(m_database, sql, nullptr, nullptr, nullptr) != SQLITE_OK) {
+        throwError("Unable to execute SQL");
+    }
+}
+
+long long SQLiteExporter::insert(Statement statement) {
+    sqlite3_stmt* prepared = m_statements[statement];
+    int result = sqlite3_step(prepared);
+    sqlite3_reset(prepared);
+    if (result != SQLITE_DONE) {
+        throwError("Unable to insert row");
+    }
+    return sqlite3_last_insert_rowid(m_database);
+}
+
+void SQLiteExporter::throwError(const std::string& context) {
+    throw std::runtime_error(context + ": " + sqlite3_errmsg(m_database));
+}
+
+void SQLiteExporter::add(const HeaderAnalyzer& analyzer) {
+    // A header that fails halfway leaves none of its rows in the transaction
+    execute("SAVEPOINT header");
+    try {
+        insertDeclarations(analyzer);
+    } catch (...) {
+        sqlite3_exec(m_database, "ROLLBACK TO header; RELEASE header", nullptr, nullptr, nullptr);
+        throw;
+    }
+    execute("RELEASE header");
+}
+
+void SQLiteExporter::insertDeclarations(const HeaderAnalyzer& analyzer) {
+    sqlite3_stmt* const* statements = m_statements;
+
+    bindText(statements[InsertHeader], 1, analyzer.getFilename());
+    long long headerId = insert(InsertHeader);
+
+    for (const auto& info : analyzer.getEnums()) {
+        sqlite3_stmt* statement = statements[InsertEnum];
+        sqlite3_bind_int64(statement, 1, headerId);
+        bindText(statement, 2, info.name);
+        bindText(statement, 3, info.underlyingType);
+        bindText(statement, 4, info.comment);
+        long long enumId = insert(InsertEnum);
+
+        statement = statements[InsertEnumerator];
+        sqlite3_bind_int64(statement, 1, enumId);
+        for (size_t i = 0; i < info.enumerators.size(); ++i) {
+            sqlite3_bind_int64(statement, 2, static_cast<long long>(i));
+            bindText(statement, 3, info.enumerators[i].first);
+            sqlite3_bind_int64(statement, 4, info.enumerators[i].second);
+            insert(InsertEnumerator);
+        }
+    }
+
+    for (const auto& info : analyzer.getStructs()) {
+        sqlite3_stmt* statement = statements[InsertStruct];
+        sqlite3_bind_int64(statement, 1, headerId);
+        bindText(statement, 2, info.name);
+        bindOptional(statement, 3, info.size);
+        bindOptional(statement, 4, info.alignment);
+        bindText(statement, 5, info.comment);
+        long long structId = insert(InsertStruct);
+
+        statement = statements[InsertMember];
+        sqlite3_bind_int64(statement, 1, structId);
+        for (size_t i = 0; i < info.members.size(); ++i) {
+            const auto& member = info.members[i];
+            sqlite3_bind_int64(statement, 2, static_cast<long long>(i));
+            bindText(statement, 3, member.name);
+            bindText(statement, 4, member.type);
+            bindText(statement, 5, member.canonicalType);
+            bindOptional(statement, 6, member.bitfieldWidth);
+            bindOptional(statement, 7, member.offset);
+            bindOptional(statement, 8, member.size);
+            insert(InsertMember);
+        }
+    }
+
+    for (const auto& info : analyzer.getFunctions()) {
+        sqlite3_stmt* statement = statements[InsertFunction];
+        sqlite3_bind_int64(statement, 1, headerId);
+        bindText(statement, 2, info.name);
+        bindText(statement, 3, info.returnType);
+        sqlite3_bind_int(statement, 4, info.isVariadic ? 1 : 0);
+        bindText(statement, 5, info.attributes);
+        bindText(statement, 6, info.comment);
+        long long functionId = insert(InsertFunction);
+
+        statement = statements[InsertParameter];
+        sqlite3_bind_int64(statement, 1, functionId);
+        for (size_t i = 0; i < info.parameters.size(); ++i) {
+            sqlite3_bind_int64(statement, 2, static_cast<long long>(i));
+            bindText(statement, 3, info.parameters[i].first);
+            bindText(statement, 4, info.parameters[i].second);
+            insert(InsertParameter);
+        }
+    }
+
+    for (const auto& info : analyzer.getVariables()) {
+        sqlite3_stmt* statement = statements[InsertVariable];
+        sqlite3_bind_int64(statement, 1, headerId);
+        bindText(statement, 2, info.name);
+        bindText(statement, 3, info.type);
+        bindText(statement, 4, info.value);
+        bindText(statement, 5, info.storageClass);
+        bindText(statement, 6, info.qualifiers);
+        bindText(statement, 7, info.comment);
+        long long variableId = insert(InsertVariable);
+
+        statement = statements[InsertDimension];
+        sqlite3_bind_int64(statement, 1, variableId);
+        for (size_t i = 0; i < info.arrayDimensions.size(); ++i) {
+            sqlite3_bind_int64(statement, 2, static_cast<long long>(i));
+            sqlite3_bind_int64(statement, 3, info.arrayDimensions[i]);
+            insert(InsertDimension);
+        }
+    }
+
+    for (const auto& info : analyzer.getTypedefs()) {
+        sqlite3_stmt* statement = statements[InsertTypedef];
+        sqlite3_bind_int64(statement, 1, headerId);
+        bindText(statement, 2, info.newName);
+        bindText(statement, 3, info.originalType);
+        bindText(statement, 4, info.qualifiers);
+        bindText(statement, 5, info.comment);
+        insert(InsertTypedef);
+    }
+}
+
+void SQLiteExporter::finish() {
+    execute(kCreateIndexes);
+    execute("COMMIT");
+    // Later additions again go into one transaction, without index maintenance
+    execute("BEGIN");
+    execute(kDropIndexes);
+}
+
+#else
+
+SQLiteExporter::SQLiteExporter(const std::string& databaseFilename) {
+    throw std::runtime_error("SQLite export not supported by this build: " + databaseFilename);
+}
+
+SQLiteExporter::~SQLiteExporter() {
+}
+
+void SQLiteExporter::add(const HeaderAnalyzer&) {
+}
+
+void SQLiteExporter::finish() {
+}
+
+#endif
+
+bool SQLiteExporter::isSupported() {
+#ifdef HEADER_ANALYZER_WITH_SQLITE
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "HeaderAnalyzer.h"
+#include <string>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/**
+ * @class SQLiteExporter
+ * @brief Bulk-loads analyzed declarations into a SQLite database.
+ *
+ * The schema is normalized into one table per declaration kind (headers, enums, structs,
+ * functions, variables, typedefs) and one per nested list (enumerators, struct_members,
+ * function_parameters, variable_dimensions), linked by integer ids. Unknown layout values and
+ * non-bitfield widths are stored as NULL.
+ *
+ * All rows are inserted with prepared statements in a single transaction that finish()
+ * commits. Indexes are dropped when the export starts and rebuilt once at the end, which is
+ * far cheaper than maintaining them row by row. Opening an existing database appends to it, so
+ * many runs can collect the declarations of a whole SDK in one file.
+ *
+ * SQLite support is only available when built with HEADER_ANALYZER_WITH_SQLITE.
+ */
+class SQLiteExporter {
+public:
+    /**
+     * @brief Opens or creates a database, creates the tables if needed and starts the export.
+     * @param databaseFilename The path of the database file.
+     * @throws std::runtime_error If SQLite support is not built in, or the database cannot be opened.
+     */
+    SQLiteExporter(const std::string& databaseFilename);
+
+    /**
+     * @brief Closes the database, discarding everything added since the last finish().
+     */
+    ~SQLiteExporter();
+
+    SQLiteExporter(const SQLiteExporter&) = delete;
+    SQLiteExporter& operator=(const SQLiteExporter&) = delete;
+
+    /**
+     * @brief Adds the declarations of one analyzed header.
+     *
+     * The header is added inside a savepoint, so it is either added completely or not at all.
+     *
+     * @param analyzer The analyzer holding the declarations; its filename is stored in headers.path.
+     * @throws std::runtime_error If a row cannot be inserted. None of the header's rows are kept.
+     */
+    void add(const HeaderAnalyzer& analyzer);
+
+    /**
+     * @brief Rebuilds the indexes and commits everything added so far.
+     *
+     * A new transaction is started afterwards, so more headers can still be added.
+     *
+     * @throws std::runtime_error If the indexes cannot be created or the commit fails.
+     */
+    void finish();
+
+    /**
+     * @brief Checks whether SQLite export is available in this build.
+     * @return True if built with HEADER_ANALYZER_WITH_SQLITE.
+     */
+    static bool isSupported();
+
+private:
+    enum Statement {
+        InsertHeader,
+        InsertEnum,
+        InsertEnumerator,
+        InsertStruct,
+        InsertMember,
+        InsertFunction,
+        InsertParameter,
+        InsertVariable,
+        InsertDimension,
+        InsertTypedef,
+        StatementCount
+    };
+
+    sqlite3* m_database = nullptr;
+    sqlite3_stmt* m_statements[StatementCount] = {};
+
+    void close();
+    void execute(const char* sql);
+    long long insert(Statement statement);
+    void insertDeclarations(const HeaderAnalyzer& analyzer);
+    void throwError(const std::string& context);
+};
@@ -0,0 +1,496 @@
+#include "StructSerializerGenerator.h"
+#include "CompressedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+namespace {
+
+// Helpers shared by all generated serializers. Scalars are converted with shifts on their bit
+// pattern, so the byte-wise path is correct on any host; compilers turn it into a single load
+// or store (plus a byte swap on big-endian hosts).
+const char* kGeneratedPrologue =
+    "#ifndef HEADER_ANALYZER_SERIALIZER_DETAIL\n"
+    "#define HEADER_ANALYZER_SERIALIZER_DETAIL\n"
+    "namespace header_analyzer_detail {\n"
+    "\n"
+    "#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)\n"
+    "inline constexpr bool kLittleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;\n"
+    "#elif defined(_WIN32)\n"
+    "inline constexpr bool kLittleEndian = true;\n"
+    "#else\n"
+    "inline constexpr bool kLittleEndian = false; // Unknown: never take the memcpy path\n"
+    "#endif\n"
+    "\n"
+    "template <std::size_t Size> struct UnsignedOfSize;\n"
+    "template <> struct UnsignedOfSize<1> { using type = std::uint8_t; };\n"
+    "template <> struct UnsignedOfSize<2> { using type = std::uint16_t; };\n"
+    "template <> struct UnsignedOfSize<4> { using type = std::uint32_t; };\n"
+    "template <> struct UnsignedOfSize<8> { using type = std::uint64_t; };\n"
+    "\n"
+    "template <typename T>\n"
+    "inline void store(unsigned char* out, const T& value) noexcept {\n"
+    "    typename UnsignedOfSize<sizeof(T)>::type bits;\n"
+    "    std::memcpy(&bits, &value, sizeof(T));\n"
+    "    for (std::size_t i = 0; i < sizeof(T); ++i) {\n"
+    "        out[i] = static_cast<unsigned char>(bits >> (8 * i));\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "template <typename T>\n"
+    "inline T load(const unsigned char* in) noexcept {\n"
+    "    if constexpr (std::is_same_v<T, bool>) {\n"
+    "        return in[0] != 0;\n"
+    "    } else {\n"
+    "        using Bits = typename UnsignedOfSize<sizeof(T)>::type;\n"
+    "        Bits bits = 0;\n"
+    "        for (std::size_t i = 0; i < sizeof(T); ++i) {\n"
+    "            bits = static_cast<Bits>(bits | static_cast<Bits>(static_cast<Bits>(in[i]) << (8 * i)));\n"
+    "        }\n"
+    "        T value;\n"
+    "        std::memcpy(&value, &bits, sizeof(T));\n"
+    "        return value;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "template <typename Array>\n"
+    "inline void storeArray(unsigned char* out, const Array& values) noexcept {\n"
+    "    using Element = std::remove_all_extents_t<Array>;\n"
+    "    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&values);\n"
+    "    for (std::size_t i = 0; i < sizeof(Array) / sizeof(Element); ++i) {\n"
+    "        Element element;\n"
+    "        std::memcpy(&element, bytes + i * sizeof(Element), sizeof(Element));\n"
+    "        store(out + i * sizeof(Element), element);\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "template <typename Array>\n"
+    "inline void loadArray(const unsigned char* in, Array& values) noexcept {\n"
+    "    using Element = std::remove_all_extents_t<Array>;\n"
+    "    unsigned char* bytes = reinterpret_cast<unsigned char*>(&values);\n"
+    "    for (std::size_t i = 0; i < sizeof(Array) / sizeof(Element); ++i) {\n"
+    "        Element element = load<Element>(in + i * sizeof(Element));\n"
+    "        std::memcpy(bytes + i * sizeof(Element), &element, sizeof(Element));\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "inline void storeBits(unsigned char* out, std::uint64_t bits, std::size_t bytes) noexcept {\n"
+    "    for (std::size_t i = 0; i < bytes; ++i) {\n"
+    "        out[i] = static_cast<unsigned char>(bits >> (8 * i));\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "inline std::uint64_t loadBits(const unsigned char* in, std::size_t bytes) noexcept {\n"
+    "    std::uint64_t bits = 0;\n"
+    "    for (std::size_t i = 0; i < bytes; ++i) {\n"
+    "        bits |= static_cast<std::uint64_t>(in[i]) << (8 * i);\n"
+    "    }\n"
+    "    return bits;\n"
+    "}\n"
+    "\n"
+    "// Converts the stored bits of a bitfield back to its type, sign-extending signed fields\n"
+    "template <typename T>\n"
+    "inline T fromBits(std::uint64_t bits, unsigned width) noexcept {\n"
+    "    if constexpr (std::is_signed_v<T>) {\n"
+    "        if (width < 64 && ((bits >> (width - 1)) & 1) != 0) {\n"
+    "            bits |= ~std::uint64_t{0} << width;\n"
+    "        }\n"
+    "    }\n"
+    "    return static_cast<T>(bits);\n"
+    "}\n"
+    "\n"
+    "} // namespace header_analyzer_detail\n"
+    "#endif\n";
+
+std::string trim(const std::string& value) {
+    size_t first = value.find_first_not_of(' ');
+    size_t last = value.find_last_not_of(' ');
+    return first == std::string::npos ? "" : value.substr(first, last - first + 1);
+}
+
+std::string bitMask(int width) {
+    return width >= 64 ? "~std::uint64_t{0}" : "((std::uint64_t{1} << " + std::to_string(width) + ") - 1)";
+}
+
+} // namespace
+
+StructSerializerGenerator::StructSerializerGenerator(const HeaderAnalyzer& analyzer, const std::string& namespaceName,
+                                                     const std::string& includePath)
+    : m_namespace(namespaceName), m_includePath(includePath) {
+    // Forward declarations have no layout; prefer the definition of each name
+    for (const auto& info : analyzer.getStructs()) {
+        auto it = m_structsByName.find(info.name);
+        if (it == m_structsByName.end()) {
+            m_structsByName[info.name] = &info;
+            m_names.push_back(info.name);
+        } else if (it->second->size < 0 && info.size >= 0) {
+            it->second = &info;
+        }
+    }
+    for (const auto& name : m_names) {
+        plan(name);
+    }
+}
+
+bool StructSerializerGenerator::isIdentifier(const std::string& name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    });
+}
+
+bool StructSerializerGenerator::isScalarType(const std::string& canonicalType) {
+    static const char* const kScalars[] = {
+        "_Bool", "bool", "char", "signed char", "unsigned char", "short", "unsigned short",
+        "int", "unsigned int", "long", "unsigned long", "long long", "unsigned long long",
+        "float", "double", "wchar_t", "char16_t", "char32_t"
+    };
+    if (canonicalType.compare(0, 5, "enum ") == 0) {
+        return true;
+    }
+    return std::find(std::begin(kScalars), std::end(kScalars), canonicalType) != std::end(kScalars);
+}
+
+const StructSerializerGenerator::StructPlan& StructSerializerGenerator::plan(const std::string& name) {
+    auto existing = m_plans.find(name);
+    if (existing != m_plans.end()) {
+        return existing->second;
+    }
+
+    // Inserted before planning the members, so that a struct containing itself is rejected
+    StructPlan& result = m_plans[name];
+    result.skipReason = "contains itself";
+    const HeaderAnalyzer::StructInfo& info = *m_structsByName.at(name);
+    result.info = &info;
+
+    if (!isIdentifier(name)) {
+        result.skipReason = "not a named struct";
+        return result;
+    }
+    if (info.size < 0) {
+        result.skipReason = "layout unknown";
+        return result;
+    }
+    std::string scoped;
+    if (!scopedName(info, scoped, result.skipReason)) {
+        return result;
+    }
+    // A struct named by a typedef has no tag to elaborate, and a tagged one is elaborated so
+    // that a function of the same name, such as stat(), does not hide it
+    result.typeName = info.tagged ? "struct " + scoped : scoped;
+
+    bool nativeLayout = true;
+    size_t offset = 0;
+    for (const auto& member : info.members) {
+        MemberPlan memberPlan;
+        std::string reason;
+        if (!planMember(member, memberPlan, reason)) {
+            result.skipReason = "member '" + member.name + "' " + reason;
+            return result;
+        }
+        memberPlan.packedOffset = offset;
+        offset += memberPlan.packedSize;
+
+        if (memberPlan.kind == MemberKind::Bitfield || memberPlan.kind == MemberKind::Padding) {
+            nativeLayout = false;
+        } else if (member.offset != static_cast<long long>(memberPlan.packedOffset * 8)) {
+            nativeLayout = false;
+        } else if (memberPlan.kind == MemberKind::Nested) {
+            nativeLayout = nativeLayout && m_plans.at(memberPlan.nestedName).nativeLayout;
+        }
+        result.members.push_back(memberPlan);
+    }
+
+    result.packedSize = offset;
+    result.nativeLayout = nativeLayout && info.size == static_cast<long long>(offset);
+    result.skipReason.clear();
+    m_order.push_back(name);
+    return result;
+}
+
+// The name of a struct in C++, where a struct declared inside another is a member of it
+bool StructSerializerGenerator::scopedName(const HeaderAnalyzer::StructInfo& info, std::string& result,
+                                           std::string& reason) const {
+    if (info.parent.empty()) {
+        result = "::" + info.name;
+        return true;
+    }
+    auto parent = m_structsByName.find(info.parent);
+    if (parent == m_structsByName.end() || !isIdentifier(info.parent)) {
+        reason = "nested in '" + info.parent + "', which is not a named struct";
+        return false;
+    }
+    if (!scopedName(*parent->second, result, reason)) {
+        return false;
+    }
+    result += "::" + info.name;
+    return true;
+}
+
+bool StructSerializerGenerator::planMember(const HeaderAnalyzer::StructMember& member, MemberPlan& result,
+                                           std::string& reason) {
+    result.member = &member;
+    const std::string& type = member.canonicalType;
+    if (type.compare(0, 6, "const ") == 0) {
+        reason = "is const";
+        return false;
+    }
+    // Every access to a volatile member is observable, which copying it as bytes is not
+    if (type.compare(0, 9, "volatile ") == 0) {
+        reason = "is volatile";
+        return false;
+    }
+    if (type.find("(anonymous") != std::string::npos || type.find("(unnamed") != std::string::npos) {
+        reason = "has an anonymous type";
+        return false;
+    }
+    if (type.find('*') != std::string::npos || type.find('(') != std::string::npos) {
+        reason = "is a pointer";
+        return false;
+    }
+
+    if (member.bitfieldWidth >= 0) {
+        if (member.name.empty() || member.bitfieldWidth == 0) {
+            result.kind = MemberKind::Padding;
+            result.packedSize = 0;
+            return true;
+        }
+        if (!isScalarType(type) || type == "float" || type == "double") {
+            reason = "is a bitfield of unsupported type '" + member.canonicalType + "'";
+            return false;
+        }
+        result.kind = MemberKind::Bitfield;
+        result.packedSize = static_cast<size_t>(member.bitfieldWidth + 7) / 8;
+        return true;
+    }
+
+    if (member.name.empty()) {
+        reason = "is anonymous";
+        return false;
+    }
+    if (member.size < 0) {
+        reason = "has an unknown size";
+        return false;
+    }
+
+    size_t bracket = type.find('[');
+    if (bracket != std::string::npos) {
+        if (!isScalarType(trim(type.substr(0, bracket)))) {
+            reason = "is an array of unsupported type '" + member.canonicalType + "'";
+            return false;
+        }
+        result.kind = MemberKind::Array;
+        result.packedSize = static_cast<size_t>(member.size);
+        return true;
+    }
+
+    if (isScalarType(type)) {
+        result.kind = MemberKind::Scalar;
+        result.packedSize = static_cast<size_t>(member.size);
+        return true;
+    }
+
+    std::string nested = type.compare(0, 7, "struct ") == 0 ? type.substr(7) : type;
+    if (m_structsByName.count(nested) != 0) {
+        const StructPlan& nestedPlan = plan(nested);
+        if (!nestedPlan.skipReason.empty()) {
+            reason = "is struct " + nested + ", which is skipped";
+            return false;
+        }
+        result.kind = MemberKind::Nested;
+        result.packedSize = nestedPlan.packedSize;
+        result.nestedName = nested;
+        return true;
+    }
+
+    reason = "has unsupported type '" + member.canonicalType + "'";
+    return false;
+}
+
+void StructSerializerGenerator::generateStruct(std::string& out, const StructPlan& plan) {
+    const HeaderAnalyzer::StructInfo& info = *plan.info;
+    const std::string& name = info.name;
+
+    out += "// struct " + name + ": " + std::to_string(info.size) + " bytes, alignment " +
+           std::to_string(info.alignment) + " on the analyzed target\n";
+    out += "namespace " + name + " {\n\n";
+    out += "using Type = " + plan.typeName + ";\n\n";
+    out += "inline constexpr std::size_t kPackedSize = " + std::to_string(plan.packedSize) + ";\n";
+    for (const auto& member : plan.members) {
+        if (member.kind != MemberKind::Padding) {
+            out += "inline constexpr std::size_t kOffset_" + member.member->name + " = " +
+                   std::to_string(member.packedOffset) + ";\n";
+        }
+    }
+    out += "\n";
+
+    // Scalars are stored with the size clang reported, so a target that disagrees fails to compile
+    bool sizeChecks = false;
+    for (const auto& member : plan.members) {
+        if (member.kind == MemberKind::Scalar || member.kind == MemberKind::Array) {
+            out += "static_assert(sizeof(Type::" + member.member->name + ") == " + std::to_string(member.member->size) +
+                   ", \"" + name + "::" + member.member->name + " differs in size from the analyzed target\");\n";
+            sizeChecks = true;
+        }
+    }
+    if (sizeChecks) {
+        out += "\n";
+    }
+
+    out += "// True when the native layout is the packed little-endian layout, so that a struct is copied as a whole\n";
+    if (plan.nativeLayout) {
+        out += "inline constexpr bool kNativeLayout = header_analyzer_detail::kLittleEndian && std::is_trivially_copyable_v<Type> &&\n";
+        out += "                                      sizeof(Type) == kPackedSize";
+        for (const auto& member : plan.members) {
+            out += " &&\n                                      offsetof(Type, " + member.member->name + ") == kOffset_" + member.member->name;
+            if (member.kind == MemberKind::Nested) {
+                out += " && " + member.nestedName + "::kNativeLayout";
+            }
+        }
+        out += ";\n\n";
+    } else {
+        out += "inline constexpr bool kNativeLayout = false;\n\n";
+    }
+
+    // encode
+    out += "inline void encode(const Type& value, unsigned char* out) noexcept {\n";
+    out += "    if constexpr (kNativeLayout) {\n";
+    out += "        std::memcpy(out, &value, kPackedSize);\n";
+    out += "    } else {\n";
+    for (const auto& member : plan.members) {
+        const std::string& field = member.member->name;
+        std::string target = "out + kOffset_" + field;
+        switch (member.kind) {
+            case MemberKind::Scalar:
+                out += "        header_analyzer_detail::store(" + target + ", value." + field + ");\n";
+                break;
+            case MemberKind::Array:
+                out += "        header_analyzer_detail::storeArray(" + target + ", value." + field + ");\n";
+                break;
+            case MemberKind::Bitfield:
+                out += "        header_analyzer_detail::storeBits(" + target + ", static_cast<std::uint64_t>(value." + field +
+                       ") & " + bitMask(member.member->bitfieldWidth) + ", " + std::to_string(member.packedSize) + ");\n";
+                break;
+            case MemberKind::Nested:
+                out += "        " + member.nestedName + "::encode(value." + field + ", " + target + ");\n";
+                break;
+            case MemberKind::Padding:
+                break;
+        }
+    }
+    if (plan.members.empty()) {
+        out += "        (void)value;\n        (void)out;\n";
+    }
+    out += "    }\n}\n\n";
+
+    // decode
+    out += "inline void decode(const unsigned char* in, Type& value) noexcept {\n";
+    out += "    if constexpr (kNativeLayout) {\n";
+    out += "        std::memcpy(&value, in, kPackedSize);\n";
+    out += "    } else {\n";
+    for (const auto& member : plan.members) {
+        const std::string& field = member.member->name;
+        std::string source = "in + kOffset_" + field;
+        switch (member.kind) {
+            case MemberKind::Scalar:
+                out += "        value." + field + " = header_analyzer_detail::load<decltype(Type::" + field + ")>(" + source + ");\n";
+                break;
+            case MemberKind::Array:
+                out += "        header_analyzer_detail::loadArray(" + source + ", value." + field + ");\n";
+                break;
+            case MemberKind::Bitfield:
+                out += "        value." + field + " = header_analyzer_detail::fromBits<decltype(Type::" + field +
+                       ")>(header_analyzer_detail::loadBits(" + source + ", " + std::to_string(member.packedSize) + "), " +
+                       std::to_string(member.member->bitfieldWidth) + ");\n";
+                break;
+            case MemberKind::Nested:
+                out += "        " + member.nestedName + "::decode(" + source + ", value." + field + ");\n";
+                break;
+            case MemberKind::Padding:
+                break;
+        }
+    }
+    if (plan.members.empty()) {
+        out += "        (void)in;\n        (void)value;\n";
+    }
+    out += "    }\n}\n";
+
+    // In-place accessors on an encoded buffer. Nested structs are accessed through their own
+    // accessors at kOffset_<member>.
+    for (const auto& member : plan.members) {
+        const std::string& field = member.member->name;
+        std::string type = "decltype(Type::" + field + ")";
+        switch (member.kind) {
+            case MemberKind::Scalar:
+                out += "\ninline " + type + " get_" + field + "(const unsigned char* in) noexcept {\n";
+                out += "    return header_analyzer_detail::load<" + type + ">(in + kOffset_" + field + ");\n}\n";
+                out += "\ninline void set_" + field + "(unsigned char* out, " + type + " value) noexcept {\n";
+                out += "    header_analyzer_detail::store(out + kOffset_" + field + ", value);\n}\n";
+                break;
+            case MemberKind::Array: {
+                std::string element = "std::remove_all_extents_t<" + type + ">";
+                out += "\ninline " + element + " get_" + field + "(const unsigned char* in, std::size_t index) noexcept {\n";
+                out += "    return header_analyzer_detail::load<" + element + ">(in + kOffset_" + field + " + index * sizeof(" + element + "));\n}\n";
+                out += "\ninline void set_" + field + "(unsigned char* out, std::size_t index, " + element + " value) noexcept {\n";
+                out += "    header_analyzer_detail::store(out + kOffset_" + field + " + index * sizeof(" + element + "), value);\n}\n";
+                break;
+            }
+            case MemberKind::Bitfield: {
+                std::string bytes = std::to_string(member.packedSize);
+                out += "\ninline " + type + " get_" + field + "(const unsigned char* in) noexcept {\n";
+                out += "    return header_analyzer_detail::fromBits<" + type + ">(header_analyzer_detail::loadBits(in + kOffset_" +
+                       field + ", " + bytes + "), " + std::to_string(member.member->bitfieldWidth) + ");\n}\n";
+                out += "\ninline void set_" + field + "(unsigned char* out, " + type + " value) noexcept {\n";
+                out += "    header_analyzer_detail::storeBits(out + kOffset_" + field + ", static_cast<std::uint64_t>(value) & " +
+                       bitMask(member.member->bitfieldWidth) + ", " + bytes + ");\n}\n";
+                break;
+            }
+            case MemberKind::Nested:
+            case MemberKind::Padding:
+                break;
+        }
+    }
+
+    out += "\n} // namespace " + name + "\n\n";
+}
+
+std::string StructSerializerGenerator::generate() const {
+    std::string out;
+    out += "// Generated by HeaderAnalyzer. Do not edit.\n";
+    out += "#pragma once\n\n";
+    out += "#include <cstddef>\n#include <cstdint>\n#include <cstring>\n#include <type_traits>\n";
+    out += "#include \"" + m_includePath + "\"\n\n";
+    out += kGeneratedPrologue;
+    out += "\nnamespace " + m_namespace + " {\n\n";
+
+    // Skipped structs are listed so that a missing serializer is easy to explain
+    for (const auto& name : m_names) {
+        const StructPlan& structPlan = m_plans.at(name);
+        if (!structPlan.skipReason.empty() && isIdentifier(name)) {
+            out += "// Skipped struct " + name + ": " + structPlan.skipReason + "\n";
+        }
+    }
+    out += "\n";
+
+    for (const auto& name : m_order) {
+        generateStruct(out, m_plans.at(name));
+    }
+    out += "} // namespace " + m_namespace + "\n";
+    return out;
+}
+
+void StructSerializerGenerator::writeToHeader(const std::string& outputFilename) const {
+    CompressedFileWriter outFile(outputFilename, Compression::None);
+    if (!outFile.isOpen()) {
+        std::cerr << outFile.getError() << std::endl;
+        return;
+    }
+
+    outFile.write(generate());
+
+    if (!outFile.close()) {
+        std::cerr << outFile.getError() << std::endl;
+    }
+}
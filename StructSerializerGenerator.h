@@ -0,0 +1,91 @@
+#pragma once
+
+#include "HeaderAnalyzer.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class StructSerializerGenerator
+ * @brief Generates a C++ header with packed little-endian encode/decode functions for structs.
+ *
+ * For each supported struct the generated header declares a namespace with kPackedSize,
+ * encode(const S&, unsigned char*), decode(const unsigned char*, S&), the packed offset of
+ * every member (kOffset_<member>) and get_<member>/set_<member> accessors that read and write a
+ * single member in place in an encoded buffer.
+ *
+ * The wire format stores the named members in declaration order without padding, every scalar
+ * in little-endian order with the size clang reported. Bitfields take the fewest whole bytes
+ * that hold their width. Nested structs are stored in their own packed format. When the layout
+ * clang reported already is the packed layout and the compiling target is little-endian and
+ * agrees with it, encode and decode are a single memcpy.
+ *
+ * Supported members are integers, bool, enums, float, double, arrays of those, and other
+ * supported structs. Structs with pointers, unions, const or volatile members or an unknown layout are
+ * skipped, with the reason noted in the generated header. A struct declared inside another one
+ * is at file scope in C but a member of the outer struct in C++, and is named that way.
+ */
+class StructSerializerGenerator {
+public:
+    /**
+     * @brief Plans serializers for the structs of an analyzed header.
+     * @param analyzer The analyzer holding the structs, including their layout.
+     * @param namespaceName The namespace the generated functions are placed in.
+     * @param includePath The header declaring the structs, as it should be #included.
+     */
+    StructSerializerGenerator(const HeaderAnalyzer& analyzer, const std::string& namespaceName,
+                              const std::string& includePath);
+
+    /**
+     * @brief Generates the header source.
+     * @return The contents of the generated C++ header.
+     */
+    std::string generate() const;
+
+    /**
+     * @brief Writes the generated header to a file.
+     * @param outputFilename The name of the output header file.
+     */
+    void writeToHeader(const std::string& outputFilename) const;
+
+private:
+    enum class MemberKind {
+        Scalar,   // Stored with its native size
+        Array,    // Scalars stored one after another
+        Bitfield, // Stored in the fewest bytes holding its width
+        Nested,   // Another struct, in its packed format
+        Padding   // Unnamed bitfield, not stored
+    };
+
+    struct MemberPlan {
+        const HeaderAnalyzer::StructMember* member;
+        MemberKind kind;
+        size_t packedOffset;
+        size_t packedSize;
+        std::string nestedName; // For Nested members
+    };
+
+    struct StructPlan {
+        const HeaderAnalyzer::StructInfo* info;
+        std::string typeName; // The struct in C++, e.g. "struct ::stat", "::Foo" or "struct ::Outer::Inner"
+        std::vector<MemberPlan> members;
+        size_t packedSize = 0;
+        bool nativeLayout = false; // The reported layout equals the packed layout
+        std::string skipReason; // Empty if the struct is supported
+    };
+
+    std::string m_namespace;
+    std::string m_includePath;
+    std::unordered_map<std::string, const HeaderAnalyzer::StructInfo*> m_structsByName;
+    std::vector<std::string> m_names; // Struct names in declaration order
+    std::unordered_map<std::string, StructPlan> m_plans;
+    std::vector<std::string> m_order; // Planned structs, nested ones before their users
+
+    const StructPlan& plan(const std::string& name);
+    bool planMember(const HeaderAnalyzer::StructMember& member, MemberPlan& result, std::string& reason);
+    bool scopedName(const HeaderAnalyzer::StructInfo& info, std::string& result, std::string& reason) const;
+
+    static bool isIdentifier(const std::string& name);
+    static bool isScalarType(const std::string& canonicalType);
+    static void generateStruct(std::string& out, const StructPlan& plan);
+};
@@ -0,0 +1,163 @@
+#include "TraceRecorder.h"
+#include <cstdio>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+// Per-thread state. The buffer itself is owned by the recorder so that it outlives the thread.
+thread_local void* tlsBuffer = nullptr;
+thread_local std::string tlsThreadName;
+
+const size_t kOutputChunkSize = 1 << 18;
+
+void appendEscaped(std::string& json, const std::string& value) {
+    for (char c : value) {
+        switch (c) {
+            case '"': json += "\\\""; break;
+            case '\\': json += "\\\\"; break;
+            case '\n': json += "\\n"; break;
+            case '\t': json += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    json += escaped;
+                } else {
+                    json += c;
+                }
+        }
+    }
+}
+
+// trace_event timestamps are in microseconds; keep nanosecond precision as decimals
+void appendMicroseconds(std::string& json, int64_t nanoseconds) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%lld.%03lld", static_cast<long long>(nanoseconds / 1000),
+                  static_cast<long long>(nanoseconds % 1000));
+    json += buffer;
+}
+
+} // namespace
+
+TraceRecorder::Span::Span(const char* name) : m_name(name), m_active(TraceRecorder::shared().isEnabled()) {
+    if (m_active) {
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+TraceRecorder::Span::Span(const char* name, const std::string& detail)
+    : m_name(name), m_active(TraceRecorder::shared().isEnabled()) {
+    if (m_active) {
+        m_detail = detail;
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+TraceRecorder::Span::~Span() {
+    if (m_active) {
+        TraceRecorder::shared().record(m_name, std::move(m_detail), m_start, std::chrono::steady_clock::now());
+    }
+}
+
+TraceRecorder::TraceRecorder() : m_epoch(std::chrono::steady_clock::now()) {
+}
+
+TraceRecorder& TraceRecorder::shared() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+void TraceRecorder::setEnabled(bool enabled) {
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void TraceRecorder::setThreadName(const std::string& name) {
+    tlsThreadName = name;
+    if (auto* buffer = static_cast<ThreadBuffer*>(tlsBuffer)) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        buffer->threadName = name;
+    }
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::threadBuffer() {
+    if (tlsBuffer == nullptr) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+        buffer->tid = static_cast<uint32_t>(m_buffers.size());
+        buffer->threadName = tlsThreadName.empty() ? "thread " + std::to_string(buffer->tid) : tlsThreadName;
+        tlsBuffer = buffer.get();
+        m_buffers.push_back(std::move(buffer));
+    }
+    return *static_cast<ThreadBuffer*>(tlsBuffer);
+}
+
+void TraceRecorder::record(const char* name, std::string&& detail, std::chrono::steady_clock::time_point start,
+                           std::chrono::steady_clock::time_point end) {
+    ThreadBuffer& buffer = threadBuffer();
+    int64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - m_epoch).count();
+    int64_t durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({name, std::move(detail), startNs, durationNs});
+}
+
+void TraceRecorder::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+    }
+}
+
+void TraceRecorder::writeToJSON(const std::string& outputFilename, Compression compression) const {
+    CompressedFileWriter outFile(outputFilename, compression);
+    if (!outFile.isOpen()) {
+        std::cerr << outFile.getError() << std::endl;
+        return;
+    }
+
+    std::string pid = std::to_string(getpid());
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        std::string tid = std::to_string(buffer->tid);
+
+        // Metadata event naming the thread's track
+        json += first ? "" : ",\n";
+        first = false;
+        json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"args\":{\"name\":\"";
+        appendEscaped(json, buffer->threadName);
+        json += "\"}}";
+
+        // One complete ("X") event per span
+        for (const auto& event : buffer->events) {
+            json += ",\n{\"ph\":\"X\",\"cat\":\"header-analyzer\",\"name\":\"";
+            json += event.name;
+            json += "\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"ts\":";
+            appendMicroseconds(json, event.start);
+            json += ",\"dur\":";
+            appendMicroseconds(json, event.duration);
+            if (!event.detail.empty()) {
+                json += ",\"args\":{\"header\":\"";
+                appendEscaped(json, event.detail);
+                json += "\"}";
+            }
+            json += "}";
+
+            if (json.size() >= kOutputChunkSize) {
+                outFile.write(std::move(json));
+                json.clear();
+            }
+        }
+    }
+
+    json += "\n]}\n";
+    outFile.write(std::move(json));
+
+    if (!outFile.close()) {
+        std::cerr << outFile.getError() << std::endl;
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "CompressedFile.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @class TraceRecorder
+ * @brief Records timed spans and writes them as a Chrome trace_event JSON file.
+ *
+ * The output can be opened in Perfetto or chrome://tracing. Recording is off by default; while
+ * it is off a span costs one relaxed atomic load. While it is on, every thread appends to its
+ * own buffer, so recording threads never contend with each other.
+ */
+class TraceRecorder {
+public:
+    /**
+     * @class Span
+     * @brief Records the time between its construction and destruction as one trace event.
+     *
+     * The name must outlive the recorder, which string literals do.
+     */
+    class Span {
+    public:
+        /**
+         * @brief Starts a span.
+         * @param name The name of the span (e.g., "parse").
+         */
+        explicit Span(const char* name);
+
+        /**
+         * @brief Starts a span with a detail shown in the trace viewer, such as the header name.
+         * @param name The name of the span (e.g., "parse").
+         * @param detail Additional information attached to the span.
+         */
+        Span(const char* name, const std::string& detail);
+
+        /**
+         * @brief Ends the span and records it.
+         */
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* m_name;
+        std::string m_detail;
+        bool m_active;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /**
+     * @brief Turns recording on or off. Spans that are already open are not affected.
+     * @param enabled True to record spans.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Checks whether spans are recorded.
+     * @return True if recording is on.
+     */
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Names the calling thread in the trace, e.g. "worker 3".
+     * @param name The name shown for the thread's track.
+     */
+    static void setThreadName(const std::string& name);
+
+    /**
+     * @brief Writes every recorded span to a trace_event JSON file.
+     * @param outputFilename The name of the output JSON file.
+     * @param compression The compression to apply, by default chosen from the extension (".gz", ".zst").
+     */
+    void writeToJSON(const std::string& outputFilename, Compression compression = Compression::Auto) const;
+
+    /**
+     * @brief Discards every recorded span.
+     */
+    void clear();
+
+    /**
+     * @brief Retrieves the process-wide recorder.
+     * @return A reference to the shared recorder.
+     */
+    static TraceRecorder& shared();
+
+private:
+    struct Event {
+        const char* name;
+        std::string detail;
+        int64_t start; // Nanoseconds since the recorder was created
+        int64_t duration;
+    };
+
+    // Events of one thread. The mutex is only contended while writing the trace out.
+    struct ThreadBuffer {
+        uint32_t tid;
+        std::string threadName;
+        mutable std::mutex mutex;
+        std::vector<Event> events;
+    };
+
+    std::atomic<bool> m_enabled{false};
+    std::chrono::steady_clock::time_point m_epoch;
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+
+    TraceRecorder();
+
+    void record(const char* name, std::string&& detail, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+    ThreadBuffer& threadBuffer();
+};
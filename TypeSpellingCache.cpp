@@ -0,0 +1,35 @@
+#include "TypeSpellingCache.h"
+
+const std::string& TypeSpellingCache::getSpelling(CXType type) {
+    ++m_statistics.lookups;
+
+    // Invalid types carry no type pointer and cannot be told apart, so they are never cached
+    const void* key = type.data[0];
+    if (key == nullptr) {
+        ++m_statistics.spellingCalls;
+        m_uncached = spell(type);
+        return m_uncached;
+    }
+
+    auto it = m_spellings.find(key);
+    if (it == m_spellings.end()) {
+        ++m_statistics.spellingCalls;
+        it = m_spellings.emplace(key, spell(type)).first;
+    }
+    return it->second;
+}
+
+const TypeSpellingCache::Statistics& TypeSpellingCache::getStatistics() const { return m_statistics; }
+
+void TypeSpellingCache::clear() {
+    std::unordered_map<const void*, std::string>().swap(m_spellings);
+    std::string().swap(m_uncached);
+}
+
+std::string TypeSpellingCache::spell(CXType type) {
+    CXString spelling = clang_getTypeSpelling(type);
+    const char* cStr = clang_getCString(spelling);
+    std::string result = cStr ? cStr : ""; // Ensure we return an empty string if null
+    clang_disposeString(spelling);
+    return result;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <clang-c/Index.h>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @class TypeSpellingCache
+ * @brief Memoizes clang_getTypeSpelling for the types of a single translation unit.
+ *
+ * Clang uniques types within a translation unit, and a CXType refers to its type through an
+ * opaque pointer that also encodes the const/volatile/restrict qualifiers. That pointer is
+ * therefore an exact identity for a type as written, sugar included, and is used as the key:
+ * each distinct type is spelled once, and later lookups reuse the stored string.
+ *
+ * A cache must not outlive, or be shared between, translation units.
+ */
+class TypeSpellingCache {
+public:
+    /**
+     * @struct Statistics
+     * @brief Counts how much work the cache saved.
+     */
+    struct Statistics {
+        size_t lookups = 0; /**< The number of spellings requested. */
+        size_t spellingCalls = 0; /**< The number of clang_getTypeSpelling calls actually made. */
+    };
+
+    /**
+     * @brief Retrieves the spelling of a type, calling into libclang only on first use.
+     * @param type The type to spell.
+     * @return A reference to the spelling, valid until the cache is cleared.
+     */
+    const std::string& getSpelling(CXType type);
+
+    /**
+     * @brief Retrieves the lookup and libclang call counts since construction.
+     * @return A constant reference to the statistics.
+     */
+    const Statistics& getStatistics() const;
+
+    /**
+     * @brief Releases all cached spellings. Statistics are kept.
+     */
+    void clear();
+
+private:
+    std::unordered_map<const void*, std::string> m_spellings;
+    std::string m_uncached;
+    Statistics m_statistics;
+
+    static std::string spell(CXType type);
+};
@@ -0,0 +1,260 @@
+// HeaderAnalyzer::loadFromXML lives in its own translation unit so that tools which only read
+// emitted XML can link it without HeaderAnalyzer.cpp, and therefore without libclang.
+
+#include "HeaderAnalyzer.h"
+#include "CompressedFile.h"
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+// Single-pass parser for exactly the XML that HeaderAnalyzer::writeToXML emits. It walks the
+// buffer once and only copies attribute values into the final Info structures.
+//
+// writeToXML does not escape attribute values, so a value is delimited by the literal text
+// that follows it in the schema (e.g. `" underlying-type="`) rather than by the next quote.
+// That keeps values containing quotes, such as string constants, intact.
+class XMLParser {
+public:
+    XMLParser(std::string_view input) : m_input(input), m_pos(0) {}
+
+    // Consumes optional whitespace followed by the given literal.
+    void expect(std::string_view literal) {
+        skipWhitespace();
+        if (m_input.compare(m_pos, literal.size(), literal) != 0) {
+            fail(literal);
+        }
+        m_pos += literal.size();
+    }
+
+    // Consumes the literal if it comes next (after whitespace).
+    bool accept(std::string_view literal) {
+        skipWhitespace();
+        if (m_input.compare(m_pos, literal.size(), literal) != 0) {
+            return false;
+        }
+        m_pos += literal.size();
+        return true;
+    }
+
+    // Returns the text up to the terminator and consumes both.
+    std::string_view until(std::string_view terminator) {
+        size_t end = m_input.find(terminator, m_pos);
+        if (end == std::string_view::npos) {
+            fail(terminator);
+        }
+        std::string_view value = m_input.substr(m_pos, end - m_pos);
+        m_pos = end + terminator.size();
+        return value;
+    }
+
+    std::string text(std::string_view terminator) {
+        return std::string(until(terminator));
+    }
+
+    template <typename Integer>
+    Integer integer(std::string_view terminator) {
+        std::string_view value = until(terminator);
+        Integer result = 0;
+        auto parsed = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (parsed.ec != std::errc() || parsed.ptr != value.data() + value.size()) {
+            throw std::runtime_error("Malformed HeaderAnalyzer XML: invalid number \"" + std::string(value) + "\"");
+        }
+        return result;
+    }
+
+    // Reads an optional <tag>text</tag> element.
+    bool optionalElement(std::string_view open, std::string_view close, std::string& value) {
+        if (!accept(open)) {
+            return false;
+        }
+        value = text(close);
+        return true;
+    }
+
+    void skipWhitespace() {
+        while (m_pos < m_input.size() && (m_input[m_pos] == ' ' || m_input[m_pos] == '\n' ||
+                                          m_input[m_pos] == '\r' || m_input[m_pos] == '\t')) {
+            ++m_pos;
+        }
+    }
+
+    bool atEnd() {
+        skipWhitespace();
+        return m_pos == m_input.size();
+    }
+
+private:
+    std::string_view m_input;
+    size_t m_pos;
+
+    [[noreturn]] void fail(std::string_view expected) const {
+        throw std::runtime_error("Malformed HeaderAnalyzer XML at offset " + std::to_string(m_pos) +
+                                 ": expected \"" + std::string(expected) + "\"");
+    }
+};
+
+HeaderAnalyzer::EnumInfo parseEnum(XMLParser& parser) {
+    HeaderAnalyzer::EnumInfo info;
+    info.name = parser.text("\" underlying-type=\"");
+    info.underlyingType = parser.text("\">");
+    parser.optionalElement("<comment>", "</comment>", info.comment);
+    parser.expect("<enumerators>");
+    while (parser.accept("<enumerator name=\"")) {
+        std::string name = parser.text("\" value=\"");
+        long long value = parser.integer<long long>("\"/>");
+        info.enumerators.emplace_back(std::move(name), value);
+    }
+    parser.expect("</enumerators>");
+    parser.expect("</enum>");
+    return info;
+}
+
+HeaderAnalyzer::TypedefInfo parseTypedef(XMLParser& parser) {
+    HeaderAnalyzer::TypedefInfo info;
+    info.newName = parser.text("\" original-type=\"");
+    info.originalType = parser.text("\">");
+    parser.optionalElement("<qualifiers>", "</qualifiers>", info.qualifiers);
+    parser.optionalElement("<comment>", "</comment>", info.comment);
+    parser.expect("</typedef>");
+    return info;
+}
+
+HeaderAnalyzer::StructInfo parseStruct(XMLParser& parser) {
+    HeaderAnalyzer::StructInfo info;
+    info.name = parser.text("\"");
+    // Files written before layout was recorded have no size and alignment
+    info.size = -1;
+    info.alignment = -1;
+    if (parser.accept("size=\"")) {
+        info.size = parser.integer<long long>("\" alignment=\"");
+        info.alignment = parser.integer<long long>("\"");
+    }
+    // Absent for tagged structs at file scope, and in files written before they were recorded
+    info.tagged = !parser.accept("tagged=\"false\"");
+    if (parser.accept("parent=\"")) {
+        info.parent = parser.text("\"");
+    }
+    parser.expect(">");
+    parser.optionalElement("<comment>", "</comment>", info.comment);
+    parser.expect("<members>");
+    while (parser.accept("<member name=\"")) {
+        HeaderAnalyzer::StructMember member;
+        member.name = parser.text("\" type=\"");
+        member.type = parser.text("\" bitfield-width=\"");
+        member.bitfieldWidth = parser.integer<int>("\"");
+        if (parser.accept("offset=\"")) {
+            member.offset = parser.integer<long long>("\" size=\"");
+            member.size = parser.integer<long long>("\" canonical-type=\"");
+            member.canonicalType = parser.text("\"/>");
+        } else {
+            parser.expect("/>");
+            member.offset = -1;
+            member.size = -1;
+        }
+        info.members.push_back(std::move(member));
+    }
+    parser.expect("</members>");
+    parser.expect("</struct>");
+    return info;
+}
+
+HeaderAnalyzer::VariableInfo parseVariable(XMLParser& parser) {
+    HeaderAnalyzer::VariableInfo info;
+    info.name = parser.text("\" type=\"");
+    info.type = parser.text("\" value=\"");
+    info.value = parser.text("\" storage-class=\"");
+    info.storageClass = parser.text("\">");
+    if (parser.accept("<array-dimensions>")) {
+        while (parser.accept("<dimension>")) {
+            info.arrayDimensions.push_back(parser.integer<int>("</dimension>"));
+        }
+        parser.expect("</array-dimensions>");
+    }
+    parser.optionalElement("<qualifiers>", "</qualifiers>", info.qualifiers);
+    parser.optionalElement("<comment>", "</comment>", info.comment);
+    parser.expect("</variable>");
+    return info;
+}
+
+HeaderAnalyzer::FunctionInfo parseFunction(XMLParser& parser) {
+    HeaderAnalyzer::FunctionInfo info;
+    info.name = parser.text("\" return-type=\"");
+    info.returnType = parser.text("\" is-variadic=\"");
+    std::string_view variadic = parser.until("\">");
+    if (variadic != "true" && variadic != "false") {
+        throw std::runtime_error("Malformed HeaderAnalyzer XML: invalid is-variadic \"" + std::string(variadic) + "\"");
+    }
+    info.isVariadic = variadic == "true";
+    parser.optionalElement("<comment>", "</comment>", info.comment);
+    parser.expect("<parameters>");
+    while (parser.accept("<parameter name=\"")) {
+        std::string name = parser.text("\" type=\"");
+        std::string type = parser.text("\"/>");
+        info.parameters.emplace_back(std::move(name), std::move(type));
+    }
+    parser.expect("</parameters>");
+    parser.optionalElement("<attributes>", "</attributes>", info.attributes);
+    parser.expect("</function>");
+    return info;
+}
+
+// Parses one section, e.g. <enums><enum name="...">...</enum>...</enums>.
+template <typename Info, typename ParseFn>
+void parseSection(XMLParser& parser, std::string_view open, std::string_view entry, std::string_view close,
+                  std::vector<Info>& result, ParseFn parse) {
+    parser.expect(open);
+    while (parser.accept(entry)) {
+        result.push_back(parse(parser));
+    }
+    parser.expect(close);
+}
+
+} // namespace
+
+HeaderAnalyzer HeaderAnalyzer::loadFromXML(const std::string& filename) {
+    std::string contents = CompressedFileReader::readAll(filename);
+
+    std::vector<EnumInfo> enums;
+    std::vector<StructInfo> structs;
+    std::vector<FunctionInfo> functions;
+    std::vector<VariableInfo> variables;
+    std::vector<TypedefInfo> typedefs;
+
+    XMLParser parser(contents);
+    parser.expect("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+    parser.expect("<header>");
+    parseSection(parser, "<enums>", "<enum name=\"", "</enums>", enums, parseEnum);
+    parseSection(parser, "<typedefs>", "<typedef new-name=\"", "</typedefs>", typedefs, parseTypedef);
+    parseSection(parser, "<structs>", "<struct name=\"", "</structs>", structs, parseStruct);
+    parseSection(parser, "<variables>", "<variable name=\"", "</variables>", variables, parseVariable);
+    parseSection(parser, "<functions>", "<function name=\"", "</functions>", functions, parseFunction);
+    parser.expect("</header>");
+    if (!parser.atEnd()) {
+        throw std::runtime_error("Malformed HeaderAnalyzer XML: trailing content in " + filename);
+    }
+
+    enums.shrink_to_fit();
+    structs.shrink_to_fit();
+    functions.shrink_to_fit();
+    variables.shrink_to_fit();
+    typedefs.shrink_to_fit();
+    return fromDeclarations(filename, std::move(enums), std::move(structs), std::move(functions),
+                            std::move(variables), std::move(typedefs));
+}
+
+// Defined here rather than in HeaderAnalyzer.cpp so that loading XML does not need libclang
+HeaderAnalyzer HeaderAnalyzer::fromDeclarations(std::string filename, std::vector<EnumInfo> enums,
+                                                std::vector<StructInfo> structs, std::vector<FunctionInfo> functions,
+                                                std::vector<VariableInfo> variables, std::vector<TypedefInfo> typedefs) {
+    HeaderAnalyzer analyzer;
+    analyzer.m_filename = std::move(filename);
+    analyzer.m_enums = std::move(enums);
+    analyzer.m_structs = std::move(structs);
+    analyzer.m_functions = std::move(functions);
+    analyzer.m_variables = std::move(variables);
+    analyzer.m_typedefs = std::move(typedefs);
+    return analyzer;
+}
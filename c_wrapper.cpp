@@ -1,18 +1,144 @@
 #include <stdlib.h>
 #include <string.h>
+#include <new>
+#include <stdexcept>
 
 // Assume the C++ HeaderAnalyzer and its dependencies are properly included and linked.
 #include "HeaderAnalyzer.h"
 #include "c_wrapper.h"
 
-c_header_analyzer* c_header_analyzer_create(const char* filename) {
-    // Create a new instance of HeaderAnalyzer
-    HeaderAnalyzer* analyzer = new HeaderAnalyzer(filename);
+// Takes ownership of analyzer. Returns NULL if the handle could not be allocated.
+static c_header_analyzer* wrap_analyzer(HeaderAnalyzer* analyzer) {
     c_header_analyzer* c_analyzer = (c_header_analyzer*)malloc(sizeof(c_header_analyzer));
+    if (!c_analyzer) {
+        delete analyzer;
+        return NULL;
+    }
     c_analyzer->header_analyzer = analyzer;
     return c_analyzer;
 }
 
+// Maps an exception thrown by HeaderAnalyzer to an error code and message.
+static c_header_analyzer_error error_from_exception(std::exception_ptr error, std::string& message) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::runtime_error& e) {
+        message = e.what();
+        return C_HEADER_ANALYZER_ERROR_PARSE;
+    } catch (const std::exception& e) {
+        message = e.what();
+        return C_HEADER_ANALYZER_ERROR_INTERNAL;
+    } catch (...) {
+        message = "Unknown error.";
+        return C_HEADER_ANALYZER_ERROR_INTERNAL;
+    }
+}
+
+c_header_analyzer* c_header_analyzer_create(const char* filename) {
+    if (!filename) {
+        return NULL;
+    }
+    // Exceptions must not propagate across the C boundary
+    try {
+        return wrap_analyzer(new HeaderAnalyzer(filename));
+    } catch (...) {
+        return NULL;
+    }
+}
+
+c_header_analyzer* c_header_analyzer_create_filtered(const char* filename, const c_header_analyzer_filter* filter) {
+    if (!filename) {
+        return NULL;
+    }
+    try {
+        HeaderAnalyzer::Options options;
+        if (filter) {
+            if ((!filter->include_prefixes && filter->include_prefix_count > 0) ||
+                (!filter->exclude_prefixes && filter->exclude_prefix_count > 0)) {
+                return NULL;
+            }
+            if (filter->kinds != 0) {
+                options.filter.setKinds(filter->kinds);
+            }
+            for (size_t i = 0; i < filter->include_prefix_count; ++i) {
+                if (!filter->include_prefixes[i]) return NULL;
+                options.filter.addIncludePrefix(filter->include_prefixes[i]);
+            }
+            for (size_t i = 0; i < filter->exclude_prefix_count; ++i) {
+                if (!filter->exclude_prefixes[i]) return NULL;
+                options.filter.addExcludePrefix(filter->exclude_prefixes[i]);
+            }
+            if (filter->include_regex) {
+                options.filter.addIncludePattern(filter->include_regex);
+            }
+            if (filter->exclude_regex) {
+                options.filter.addExcludePattern(filter->exclude_regex);
+            }
+        }
+        return wrap_analyzer(new HeaderAnalyzer(filename, options));
+    } catch (...) {
+        return NULL;
+    }
+}
+
+c_header_analyzer* c_header_analyzer_create_from_buffer(const char* filename, const char* contents, size_t length,
+                                                       const c_unsaved_file* includes, size_t include_count) {
+    if (!filename || (!contents && length > 0) || (!includes && include_count > 0)) {
+        return NULL;
+    }
+    try {
+        HeaderAnalyzer::Options options;
+        options.unsavedFiles.reserve(include_count);
+        for (size_t i = 0; i < include_count; ++i) {
+            if (!includes[i].filename || (!includes[i].contents && includes[i].length > 0)) {
+                return NULL;
+            }
+            options.unsavedFiles.push_back({includes[i].filename, includes[i].length > 0 ? std::string(includes[i].contents, includes[i].length) : std::string()});
+        }
+        std::string buffer = length > 0 ? std::string(contents, length) : std::string();
+        return wrap_analyzer(new HeaderAnalyzer(filename, buffer, options));
+    } catch (...) {
+        return NULL;
+    }
+}
+
+c_header_analyzer* c_header_analyzer_load_xml(const char* filename) {
+    if (!filename) {
+        return NULL;
+    }
+    try {
+        return wrap_analyzer(new HeaderAnalyzer(HeaderAnalyzer::loadFromXML(filename)));
+    } catch (...) {
+        return NULL;
+    }
+}
+
+c_header_analyzer_error c_header_analyzer_create_async(const char* filename, c_header_analyzer_callback callback, void* user_data) {
+    if (!filename || !callback) {
+        return C_HEADER_ANALYZER_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        HeaderAnalyzer::analyzeAsync(filename, HeaderAnalyzer::Options(),
+            [callback, user_data](std::unique_ptr<HeaderAnalyzer> analyzer, std::exception_ptr error) {
+                if (error) {
+                    std::string message;
+                    c_header_analyzer_error code = error_from_exception(error, message);
+                    callback(NULL, code, message.c_str(), user_data);
+                    return;
+                }
+                c_header_analyzer* c_analyzer = wrap_analyzer(analyzer.release());
+                if (!c_analyzer) {
+                    callback(NULL, C_HEADER_ANALYZER_ERROR_INTERNAL, "Out of memory.", user_data);
+                    return;
+                }
+                callback(c_analyzer, C_HEADER_ANALYZER_OK, "", user_data);
+            });
+    } catch (...) {
+        return C_HEADER_ANALYZER_ERROR_INTERNAL;
+    }
+    return C_HEADER_ANALYZER_OK;
+}
+
 void c_header_analyzer_destroy(c_header_analyzer* analyzer) {
     if (analyzer) {
         delete static_cast<HeaderAnalyzer*>(analyzer->header_analyzer);
@@ -67,6 +193,8 @@ const c_struct_info* c_header_analyzer_get_structs(c_header_analyzer* analyzer,
     for (size_t i = 0; i < *count; ++i) {
         c_structs[i].name = strdup(structs[i].name.c_str());
         c_structs[i].comment = strdup(structs[i].comment.c_str());
+        c_structs[i].size = structs[i].size;
+        c_structs[i].alignment = structs[i].alignment;
         
         c_structs[i].member_count = structs[i].members.size();
         c_structs[i].members = (c_struct_member*)malloc(sizeof(c_struct_member) * c_structs[i].member_count);
@@ -75,6 +203,9 @@ const c_struct_info* c_header_analyzer_get_structs(c_header_analyzer* analyzer,
             c_structs[i].members[j].name = strdup(structs[i].members[j].name.c_str());
             c_structs[i].members[j].type = strdup(structs[i].members[j].type.c_str());
             c_structs[i].members[j].bitfield_width = structs[i].members[j].bitfieldWidth;
+            c_structs[i].members[j].offset = structs[i].members[j].offset;
+            c_structs[i].members[j].size = structs[i].members[j].size;
+            c_structs[i].members[j].canonical_type = strdup(structs[i].members[j].canonicalType.c_str());
         }
     }
     
@@ -88,6 +219,7 @@ void c_struct_info_destroy(c_struct_info* structs, size_t count) {
         for (size_t j = 0; j < structs[i].member_count; ++j) {
             free(structs[i].members[j].name);
             free(structs[i].members[j].type);
+            free(structs[i].members[j].canonical_type);
         }
         free(structs[i].members);
     }
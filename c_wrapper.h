@@ -17,6 +17,9 @@ typedef struct {
     char* name; // The name of the structure member.
     char* type; // The type of the structure member.
     int bitfield_width; // The width of the bitfield, if applicable.
+    long long offset; // The offset from the start of the structure in bits, -1 if unknown.
+    long long size; // The size of the member type in bytes, -1 if unknown.
+    char* canonical_type; // The type with all typedefs resolved.
 } c_struct_member;
 
 typedef struct {
@@ -24,6 +27,8 @@ typedef struct {
     c_struct_member* members; // An array of members belonging to the structure.
     size_t member_count; // Count of members.
     char* comment; // An optional comment describing the structure.
+    long long size; // The size of the structure in bytes, -1 if unknown.
+    long long alignment; // The alignment of the structure in bytes, -1 if unknown.
 } c_struct_info;
 
 typedef struct {
@@ -59,9 +64,70 @@ typedef struct {
     void* header_analyzer; // Pointer to the C++ HeaderAnalyzer instance.
 } c_header_analyzer;
 
+// An in-memory file passed to libclang instead of reading it from disk
+typedef struct {
+    const char* filename; // The path the file is known by, as resolved by #include directives.
+    const char* contents; // The contents of the file, not necessarily null-terminated.
+    size_t length; // The length of contents in bytes.
+} c_unsaved_file;
+
+// Declaration kinds, combined as a bitmask in c_header_analyzer_filter.kinds
+typedef enum {
+    C_HEADER_ANALYZER_KIND_ENUM = 1 << 0,
+    C_HEADER_ANALYZER_KIND_STRUCT = 1 << 1,
+    C_HEADER_ANALYZER_KIND_FUNCTION = 1 << 2,
+    C_HEADER_ANALYZER_KIND_VARIABLE = 1 << 3,
+    C_HEADER_ANALYZER_KIND_TYPEDEF = 1 << 4
+} c_header_analyzer_kind;
+
+// Selects the declarations to extract. A zero-initialized filter extracts everything.
+typedef struct {
+    unsigned kinds; // Kinds to extract as c_header_analyzer_kind flags, 0 for all kinds.
+    const char* const* include_prefixes; // Only extract names starting with one of these prefixes.
+    size_t include_prefix_count; // Count of include prefixes, 0 to not filter by prefix.
+    const char* const* exclude_prefixes; // Skip names starting with one of these prefixes.
+    size_t exclude_prefix_count; // Count of exclude prefixes.
+    const char* include_regex; // Only extract names matching this ECMAScript regex, or NULL.
+    const char* exclude_regex; // Skip names matching this ECMAScript regex, or NULL.
+} c_header_analyzer_filter;
+
+// Error codes returned by the C wrapper instead of C++ exceptions
+typedef enum {
+    C_HEADER_ANALYZER_OK = 0, // No error.
+    C_HEADER_ANALYZER_ERROR_INVALID_ARGUMENT = 1, // A required argument was NULL.
+    C_HEADER_ANALYZER_ERROR_PARSE = 2, // The header could not be parsed.
+    C_HEADER_ANALYZER_ERROR_INTERNAL = 3 // Any other failure, such as running out of memory.
+} c_header_analyzer_error;
+
+// Completion callback for asynchronous analysis. On success, analyzer is owned by the callee
+// and must be released with c_header_analyzer_destroy; on failure it is NULL. message is only
+// valid for the duration of the call. The callback runs on an internal worker thread and must
+// not call c_header_analyzer_create_async, which can deadlock once the pool's queue is full.
+typedef void (*c_header_analyzer_callback)(c_header_analyzer* analyzer, c_header_analyzer_error error,
+                                           const char* message, void* user_data);
+
 // Function declarations for the C wrapper
 
+// Returns NULL if the header could not be analyzed.
 c_header_analyzer* c_header_analyzer_create(const char* filename);
+
+// Only extracts the declarations selected by filter, which may be NULL to extract everything.
+// Returns NULL if the header could not be analyzed or a regex is invalid.
+c_header_analyzer* c_header_analyzer_create_filtered(const char* filename, const c_header_analyzer_filter* filter);
+
+// Analyzes a header held in memory; no file named filename needs to exist. includes may
+// provide in-memory versions of included files. Returns NULL if the header could not be analyzed.
+c_header_analyzer* c_header_analyzer_create_from_buffer(const char* filename, const char* contents, size_t length,
+                                                       const c_unsaved_file* includes, size_t include_count);
+
+// Loads declarations from a file written by c_header_analyzer_write_to_xml (optionally gzip or
+// zstd compressed) without parsing any header. Returns NULL if the file cannot be loaded.
+c_header_analyzer* c_header_analyzer_load_xml(const char* filename);
+
+// Starts analyzing a header on an internal bounded thread pool and returns immediately, unless
+// the pool's queue is full. callback is invoked exactly once if C_HEADER_ANALYZER_OK is returned.
+// Must not be called from a callback, since a blocked worker cannot drain the queue it waits on.
+c_header_analyzer_error c_header_analyzer_create_async(const char* filename, c_header_analyzer_callback callback, void* user_data);
 void c_header_analyzer_destroy(c_header_analyzer* analyzer);
 
 const c_enum_info* c_header_analyzer_get_enums(c_header_analyzer* analyzer, size_t* count);
@@ -2,7 +2,7 @@
 #include "c_wrapper.h" // Include the header file with the C wrapper declarations.
 
 // Compile using
-// g++ c_wrapper_example.c c_wrapper.cpp HeaderAnalyzer.cpp  -I/usr/lib/llvm-16/include -L/usr/lib/llvm-16/lib -lclang
+// g++ c_wrapper_example.c c_wrapper.cpp HeaderAnalyzer.cpp HeaderVisitor.cpp BoundedExecutor.cpp TypeSpellingCache.cpp CompressedFile.cpp XMLLoader.cpp TraceRecorder.cpp DeclarationFilter.cpp -I/usr/lib/llvm-16/include -L/usr/lib/llvm-16/lib -lclang -lz -pthread
 
 int main() {
     const char* filename = "example_header.h"; // Path to the header file to analyze.
@@ -0,0 +1,58 @@
+// Checks that the header generated by --struct-serializers compiles and round-trips values for
+// structs named by a typedef, tagged structs hidden by a function of the same name, and structs
+// nested in another struct. Exits with 1 if a value does not survive encode and decode.
+//
+// Generate the serializers and compile using
+// ./HeaderAnalyzer --struct-serializers=check_wire struct_serializer_check.h struct_serializer_check_wire.h
+// g++ -std=c++17 -Wall -Wextra -Werror struct_serializer_check.cpp
+// and run as ./a.out.
+
+#include "struct_serializer_check_wire.h"
+#include <iostream>
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "Changed by encode and decode: " << what << std::endl;
+        ++failures;
+    }
+}
+
+} // namespace
+
+int main() {
+    unsigned char buffer[256];
+
+    Point2 point = {-5, 7};
+    check_wire::Point2::encode(point, buffer);
+    Point2 pointOut = {};
+    check_wire::Point2::decode(buffer, pointOut);
+    expect(pointOut.x == -5 && pointOut.y == 7, "Point2");
+
+    struct Sample sample = {3, 0x01020304u};
+    check_wire::Sample::encode(sample, buffer);
+    expect(check_wire::Sample::get_value(buffer) == 0x01020304u, "Sample::value");
+
+    struct Outer outer = {{0xBEEF}, 9};
+    check_wire::Outer::encode(outer, buffer);
+    struct Outer outerOut = {};
+    check_wire::Outer::decode(buffer, outerOut);
+    expect(outerOut.inner.code == 0xBEEF && outerOut.flags == 9, "Outer");
+    expect(check_wire::Inner::get_code(buffer + check_wire::Outer::kOffset_inner) == 0xBEEF, "Outer::Inner::code");
+
+    Wrapper wrapper = {{42}};
+    check_wire::Wrapper::encode(wrapper, buffer);
+    expect(check_wire::Payload::get_size(buffer) == 42, "Wrapper::Payload::size");
+
+    // Only needs to compile: struct stat next to the function stat()
+    static_assert(check_wire::stat::kPackedSize > 0, "struct stat has a serializer");
+
+    if (failures != 0) {
+        return 1;
+    }
+    std::cout << "struct serializers compile and round-trip" << std::endl;
+    return 0;
+}
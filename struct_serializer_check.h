@@ -0,0 +1,43 @@
+#ifndef STRUCT_SERIALIZER_CHECK_H
+#define STRUCT_SERIALIZER_CHECK_H
+
+// Structs whose C++ names differ from the way C declares them, compiled by
+// struct_serializer_check.cpp against the serializers generated for this header.
+
+#include <stdint.h>   // Declares __fsid_t and other structs named by a typedef
+#include <sys/stat.h> // struct stat shares its name with the function stat()
+
+// Named by a typedef, so C++ spells it ::Point2, not struct ::Point2
+typedef struct {
+    int32_t x;
+    int16_t y;
+} Point2;
+
+// Tagged, and also named by a typedef of a different name
+typedef struct Sample {
+    uint8_t channel;
+    uint32_t value;
+} SampleT;
+
+// In C, Inner is declared at file scope; in C++ it is Outer::Inner
+struct Outer {
+    struct Inner {
+        uint16_t code;
+    } inner;
+    uint8_t flags;
+};
+
+// A nested struct inside a struct named by a typedef is Wrapper::Payload in C++
+typedef struct {
+    struct Payload {
+        uint32_t size;
+    } payload;
+} Wrapper;
+
+// Skipped for its volatile member, which must not break the rest of the generated header
+struct Registers {
+    volatile uint32_t status;
+    uint32_t mask;
+};
+
+#endif
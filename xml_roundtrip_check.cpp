@@ -0,0 +1,38 @@
+// Checks that writeToXML and loadFromXML preserve every field HeaderDiff compares: a header
+// diffed against its own cached XML must have no changes. Exits with 1 if it does.
+//
+// Compile using
+// g++ xml_roundtrip_check.cpp HeaderAnalyzer.cpp HeaderVisitor.cpp HeaderDiff.cpp BoundedExecutor.cpp TypeSpellingCache.cpp CompressedFile.cpp XMLLoader.cpp TraceRecorder.cpp DeclarationFilter.cpp -I/usr/lib/llvm-16/include -L/usr/lib/llvm-16/lib -lclang -lz -pthread
+// and run as ./a.out [header] [scratch.xml], by default on example_header.h.
+
+#include "HeaderAnalyzer.h"
+#include "HeaderDiff.h"
+#include <cstdio>
+#include <exception>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    const std::string header = argc > 1 ? argv[1] : "example_header.h";
+    const std::string cached = argc > 2 ? argv[2] : "xml_roundtrip_check.xml";
+
+    try {
+        HeaderAnalyzer analyzed(header);
+        analyzed.writeToXML(cached, Compression::None);
+        HeaderAnalyzer loaded = HeaderAnalyzer::loadFromXML(cached);
+        std::remove(cached.c_str());
+
+        HeaderDiff diff(analyzed, loaded);
+        if (!diff.empty()) {
+            for (const auto& change : diff.getChanges()) {
+                std::cerr << "Changed by the XML round trip: " << change.name << std::endl;
+            }
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << header << ": XML round trip preserves all declarations" << std::endl;
+    return 0;
+}